@@ -2,6 +2,7 @@
 #define CPU_H
 #include "CPUOpcodes.h"
 #include "MainBus.h"
+#include "SaveState.h"
 
 namespace sn
 {
@@ -12,26 +13,34 @@ namespace sn
 
             CPU(MainBus &mem);
 
+            //Runs one whole instruction (or interrupt sequence) and returns the CPU cycles it took
+            int executeInstruction();
+            //Cycle by cycle, an instruction is executed once the previous one's cycles have elapsed
             void step();
             void reset();
             void reset(Address start_addr);
             void log();
 
             Address getPC() { return r_PC; }
+            //Cycles since reset, up to and including the first one of the current instruction
+            std::uint64_t getCycles() { return m_cycles; }
             void skipDMACycles();
 
             void interrupt(InterruptType type);
 
+            void saveState(StateWriter& state);
+            void loadState(StateReader& state);
+
         private:
             void interruptSequence(InterruptType type);
+            //Executes the next instruction, adding its cycle count to m_skipCycles
+            void executeNext();
 
-            //Instructions are split into five sets to make decoding easier.
-            //These functions return true if they succeed
-            bool executeImplied(Byte opcode);
-            bool executeBranch(Byte opcode);
-            bool executeType0(Byte opcode);
-            bool executeType1(Byte opcode);
-            bool executeType2(Byte opcode);
+            //Opcodes are predecoded in OpcodeTable, so an instruction is just an
+            //operand fetch by addressing mode followed by a jump to its operation
+            Address fetchOperand(Opcode opcode);
+            void execute(Opcode opcode, Address location);
+            void branch(bool condition, Address location);
 
             Address readAddress(Address addr);
 
@@ -43,7 +52,7 @@ namespace sn
             void setZN(Byte value);
 
             int m_skipCycles;
-            int m_cycles;
+            std::uint64_t m_cycles;
 
             //Registers
             Address r_PC;
@@ -1,123 +1,38 @@
 #ifndef CPUOPCODES_H_INCLUDED
 #define CPUOPCODES_H_INCLUDED
+#include <cstdint>
 
 namespace sn
 {
-    const auto InstructionModeMask = 0x3;
-
-    const auto OperationMask = 0xe0;
-    const auto OperationShift = 5;
-
-    const auto AddrModeMask = 0x1c;
-    const auto AddrModeShift = 2;
-
-    const auto BranchInstructionMask = 0x1f;
-    const auto BranchInstructionMaskResult = 0x10;
-    const auto BranchConditionMask = 0x20;
-    const auto BranchOnFlagShift = 6;
-
     const auto NMIVector = 0xfffa;
     const auto ResetVector = 0xfffc;
     const auto IRQVector = 0xfffe;
 
-    enum BranchOnFlag
-    {
-        Negative,
-        Overflow,
-        Carry,
-        Zero
-    };
-
-    enum Operation1
-    {
-        ORA,
-        AND,
-        EOR,
-        ADC,
-        STA,
-        LDA,
-        CMP,
-        SBC,
-    };
-
-    enum AddrMode1
+    //Mnemonics of the official 6502 instructions, XXX marks an unused opcode
+    enum Operation : std::uint8_t
     {
-        IndexedIndirectX,
-        ZeroPage,
-        Immediate,
-        Absolute,
-        IndirectY,
-        IndexedX,
-        AbsoluteY,
-        AbsoluteX,
+        ADC, AND, ASL, BCC, BCS, BEQ, BIT, BMI, BNE, BPL, BRK, BVC, BVS, CLC,
+        CLD, CLI, CLV, CMP, CPX, CPY, DEC, DEX, DEY, EOR, INC, INX, INY, JMP,
+        JSR, LDA, LDX, LDY, LSR, NOP, ORA, PHA, PHP, PLA, PLP, ROL, ROR, RTI,
+        RTS, SBC, SEC, SED, SEI, STA, STX, STY, TAX, TAY, TSX, TXA, TXS, TYA,
+        XXX,
     };
 
-    enum Operation2
+    enum AddressingMode : std::uint8_t
     {
-        ASL,
-        ROL,
-        LSR,
-        ROR,
-        STX,
-        LDX,
-        DEC,
-        INC,
-    };
-
-    enum AddrMode2
-    {
-        Immediate_,
-        ZeroPage_,
-        Accumulator,
-        Absolute_,
-        Indexed         = 5,
-        AbsoluteIndexed = 7,
-    };
-
-    enum Operation0
-    {
-        BIT  = 1,
-        STY  = 4,
-        LDY,
-        CPY,
-        CPX,
-    };
-
-    enum OperationImplied
-    {
-        NOP = 0xea,
-        BRK = 0x00,
-        JSR = 0x20,
-        RTI = 0x40,
-        RTS = 0x60,
-
-        JMP  = 0x4C,
-        JMPI = 0x6C, //JMP Indirect
-
-        PHP = 0x08,
-        PLP = 0x28,
-        PHA = 0x48,
-        PLA = 0x68,
-
-        DEY = 0x88,
-        DEX = 0xca,
-        TAY = 0xa8,
-        INY = 0xc8,
-        INX = 0xe8,
-
-        CLC = 0x18,
-        SEC = 0x38,
-        CLI = 0x58,
-        SEI = 0x78,
-        TYA = 0x98,
-        CLV = 0xb8,
-        CLD = 0xd8,
-        SED = 0xf8,
-
-        TXA = 0x8a,
-        TXS = 0x9a,
-        TAX = 0xaa,
-        TSX = 0xba,
+        IMP,    //Implied
+        ACC,    //Accumulator
+        IMM,    //Immediate
+        ZPG,    //Zero page
+        ZPX,    //Zero page indexed with X
+        ZPY,    //Zero page indexed with Y
+        REL,    //Relative (branches)
+        ABS,    //Absolute
+        ABX,    //Absolute indexed with X
+        ABY,    //Absolute indexed with Y
+        IND,    //Indirect (JMP only)
+        IZX,    //Indexed indirect, (zp,X)
+        IZY,    //Indirect indexed, (zp),Y
     };
 
     enum InterruptType
@@ -128,7 +43,7 @@ namespace sn
     };
 
     //0 implies unused opcode
-    static const int OperationCycles[0x100] = {
+    constexpr int OperationCycles[0x100] = {
             7, 6, 0, 0, 0, 3, 5, 0, 3, 2, 2, 0, 0, 4, 6, 0,
             2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0,
             6, 6, 0, 0, 3, 3, 5, 0, 4, 2, 2, 0, 4, 4, 6, 0,
@@ -143,9 +58,77 @@ namespace sn
             2, 5, 0, 0, 4, 4, 4, 0, 2, 4, 2, 0, 4, 4, 4, 0,
             2, 6, 0, 0, 3, 3, 5, 0, 2, 2, 2, 0, 4, 4, 6, 0,
             2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0,
-            2, 6, 0, 0, 3, 3, 5, 0, 2, 2, 2, 2, 4, 4, 6, 0,
+            2, 6, 0, 0, 3, 3, 5, 0, 2, 2, 2, 0, 4, 4, 6, 0,
             2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0,
         };
+
+    constexpr Operation OpcodeOperations[0x100] = {
+            BRK, ORA, XXX, XXX, XXX, ORA, ASL, XXX, PHP, ORA, ASL, XXX, XXX, ORA, ASL, XXX, // 0x00
+            BPL, ORA, XXX, XXX, XXX, ORA, ASL, XXX, CLC, ORA, XXX, XXX, XXX, ORA, ASL, XXX, // 0x10
+            JSR, AND, XXX, XXX, BIT, AND, ROL, XXX, PLP, AND, ROL, XXX, BIT, AND, ROL, XXX, // 0x20
+            BMI, AND, XXX, XXX, XXX, AND, ROL, XXX, SEC, AND, XXX, XXX, XXX, AND, ROL, XXX, // 0x30
+            RTI, EOR, XXX, XXX, XXX, EOR, LSR, XXX, PHA, EOR, LSR, XXX, JMP, EOR, LSR, XXX, // 0x40
+            BVC, EOR, XXX, XXX, XXX, EOR, LSR, XXX, CLI, EOR, XXX, XXX, XXX, EOR, LSR, XXX, // 0x50
+            RTS, ADC, XXX, XXX, XXX, ADC, ROR, XXX, PLA, ADC, ROR, XXX, JMP, ADC, ROR, XXX, // 0x60
+            BVS, ADC, XXX, XXX, XXX, ADC, ROR, XXX, SEI, ADC, XXX, XXX, XXX, ADC, ROR, XXX, // 0x70
+            XXX, STA, XXX, XXX, STY, STA, STX, XXX, DEY, XXX, TXA, XXX, STY, STA, STX, XXX, // 0x80
+            BCC, STA, XXX, XXX, STY, STA, STX, XXX, TYA, STA, TXS, XXX, XXX, STA, XXX, XXX, // 0x90
+            LDY, LDA, LDX, XXX, LDY, LDA, LDX, XXX, TAY, LDA, TAX, XXX, LDY, LDA, LDX, XXX, // 0xa0
+            BCS, LDA, XXX, XXX, LDY, LDA, LDX, XXX, CLV, LDA, TSX, XXX, LDY, LDA, LDX, XXX, // 0xb0
+            CPY, CMP, XXX, XXX, CPY, CMP, DEC, XXX, INY, CMP, DEX, XXX, CPY, CMP, DEC, XXX, // 0xc0
+            BNE, CMP, XXX, XXX, XXX, CMP, DEC, XXX, CLD, CMP, XXX, XXX, XXX, CMP, DEC, XXX, // 0xd0
+            CPX, SBC, XXX, XXX, CPX, SBC, INC, XXX, INX, SBC, NOP, XXX, CPX, SBC, INC, XXX, // 0xe0
+            BEQ, SBC, XXX, XXX, XXX, SBC, INC, XXX, SED, SBC, XXX, XXX, XXX, SBC, INC, XXX, // 0xf0
+        };
+
+    constexpr AddressingMode OpcodeAddressingModes[0x100] = {
+            IMP, IZX, IMP, IMP, IMP, ZPG, ZPG, IMP, IMP, IMM, ACC, IMP, IMP, ABS, ABS, IMP, // 0x00
+            REL, IZY, IMP, IMP, IMP, ZPX, ZPX, IMP, IMP, ABY, IMP, IMP, IMP, ABX, ABX, IMP, // 0x10
+            ABS, IZX, IMP, IMP, ZPG, ZPG, ZPG, IMP, IMP, IMM, ACC, IMP, ABS, ABS, ABS, IMP, // 0x20
+            REL, IZY, IMP, IMP, IMP, ZPX, ZPX, IMP, IMP, ABY, IMP, IMP, IMP, ABX, ABX, IMP, // 0x30
+            IMP, IZX, IMP, IMP, IMP, ZPG, ZPG, IMP, IMP, IMM, ACC, IMP, ABS, ABS, ABS, IMP, // 0x40
+            REL, IZY, IMP, IMP, IMP, ZPX, ZPX, IMP, IMP, ABY, IMP, IMP, IMP, ABX, ABX, IMP, // 0x50
+            IMP, IZX, IMP, IMP, IMP, ZPG, ZPG, IMP, IMP, IMM, ACC, IMP, IND, ABS, ABS, IMP, // 0x60
+            REL, IZY, IMP, IMP, IMP, ZPX, ZPX, IMP, IMP, ABY, IMP, IMP, IMP, ABX, ABX, IMP, // 0x70
+            IMP, IZX, IMP, IMP, ZPG, ZPG, ZPG, IMP, IMP, IMP, IMP, IMP, ABS, ABS, ABS, IMP, // 0x80
+            REL, IZY, IMP, IMP, ZPX, ZPX, ZPY, IMP, IMP, ABY, IMP, IMP, IMP, ABX, IMP, IMP, // 0x90
+            IMM, IZX, IMM, IMP, ZPG, ZPG, ZPG, IMP, IMP, IMM, IMP, IMP, ABS, ABS, ABS, IMP, // 0xa0
+            REL, IZY, IMP, IMP, ZPX, ZPX, ZPY, IMP, IMP, ABY, IMP, IMP, ABX, ABX, ABY, IMP, // 0xb0
+            IMM, IZX, IMP, IMP, ZPG, ZPG, ZPG, IMP, IMP, IMM, IMP, IMP, ABS, ABS, ABS, IMP, // 0xc0
+            REL, IZY, IMP, IMP, IMP, ZPX, ZPX, IMP, IMP, ABY, IMP, IMP, IMP, ABX, ABX, IMP, // 0xd0
+            IMM, IZX, IMP, IMP, ZPG, ZPG, ZPG, IMP, IMP, IMM, IMP, IMP, ABS, ABS, ABS, IMP, // 0xe0
+            REL, IZY, IMP, IMP, IMP, ZPX, ZPX, IMP, IMP, ABY, IMP, IMP, IMP, ABX, ABX, IMP, // 0xf0
+        };
+
+    //Everything the interpreter needs to know about an opcode, so it doesn't have to decode it at run time
+    struct Opcode
+    {
+        Operation operation;
+        AddressingMode mode;
+        std::uint8_t cycles;        //0 implies unused opcode
+        bool pageCrossPenalty;      //Takes one more cycle if the indexed operand crosses a page
+    };
+
+    constexpr Opcode decodeOpcode(int opcode)
+    {
+        return { OpcodeOperations[opcode],
+                 OpcodeAddressingModes[opcode],
+                 static_cast<std::uint8_t>(OperationCycles[opcode]),
+                 OpcodeOperations[opcode] != STA && (OpcodeAddressingModes[opcode] == ABX ||
+                                                     OpcodeAddressingModes[opcode] == ABY ||
+                                                     OpcodeAddressingModes[opcode] == IZY) };
+    }
+
+#define SN_DECODE_4(n)  decodeOpcode(n), decodeOpcode(n + 1), decodeOpcode(n + 2), decodeOpcode(n + 3)
+#define SN_DECODE_16(n) SN_DECODE_4(n), SN_DECODE_4(n + 4), SN_DECODE_4(n + 8), SN_DECODE_4(n + 12)
+#define SN_DECODE_64(n) SN_DECODE_16(n), SN_DECODE_16(n + 16), SN_DECODE_16(n + 32), SN_DECODE_16(n + 48)
+    //Built at compile time from the tables above
+    constexpr Opcode OpcodeTable[0x100] = {
+            SN_DECODE_64(0x00), SN_DECODE_64(0x40), SN_DECODE_64(0x80), SN_DECODE_64(0xc0)
+        };
+#undef SN_DECODE_64
+#undef SN_DECODE_16
+#undef SN_DECODE_4
 };
 
 #endif // CPUOPCODES_H_INCLUDED
@@ -3,29 +3,103 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "MappedFile.h"
 
 namespace sn
 {
     using Byte = std::uint8_t;
     using Address = std::uint16_t;
 
+    //Read-only bytes of ROM, wherever the cartridge keeps them
+    class ROMView
+    {
+        public:
+            ROMView() : m_data(nullptr), m_size(0) {}
+            ROMView(const Byte* data, std::size_t size) : m_data(data), m_size(size) {}
+
+            const Byte* data() const { return m_data; }
+            std::size_t size() const { return m_size; }
+            const Byte& operator[](std::size_t index) const { return m_data[index]; }
+            bool operator==(const ROMView& other) const
+            {
+                return m_size == other.m_size && (m_size == 0 || std::memcmp(m_data, other.m_data, m_size) == 0);
+            }
+        private:
+            const Byte* m_data;
+            std::size_t m_size;
+    };
+
+    //What the header of an iNES or NES 2.0 image says
+    struct ROMHeader
+    {
+        enum Region : Byte
+        {
+            NTSC,
+            PAL,
+            MultiRegion,
+            Dendy,
+        };
+
+        bool nes2;
+        std::uint16_t mapper;
+        //16KB banks of PRG ROM and 8KB banks of CHR ROM, none meaning the cartridge has CHR RAM
+        std::uint16_t prgBanks;
+        std::uint16_t chrBanks;
+        Byte nameTableMirroring;
+        bool extendedRAM;
+        bool trainer;
+        Region region;
+    };
+
     class Cartridge
     {
         public:
             Cartridge();
-            bool loadFromFile(std::string path);
-            const std::vector<Byte>& getROM();
-            const std::vector<Byte>& getVROM();
+            //Reads the header at the start of an image, false if it doesn't start with one
+            static bool parseHeader(const Byte* image, std::size_t size, ROMHeader& header);
+            //Whether a cartridge with this header can be loaded and run, given the size of the whole image.
+            //Logs why not.
+            static bool isSupported(const ROMHeader& header, std::size_t size);
+            //The hash getHash() gives for this ROM
+            static std::uint64_t hash(const ROMView& prg, const ROMView& chr, std::uint16_t mapper);
+
+            //With mapFile, the file is mapped read-only instead of read: nothing is copied, so loading
+            //takes next to no time and the memory is the page cache's, shared with every process using
+            //the file. It mustn't be changed while loaded then. Where mapping isn't supported it's read.
+            bool loadFromFile(std::string path, bool mapFile = false);
+            const ROMView& getROM();
+            const ROMView& getVROM();
             Byte getMapper();
             Byte getNameTableMirroring();
             bool hasExtendedRAM();
+            //64-bit FNV-1a of PRG and CHR ROM and the mapper number, identifies the game
+            std::uint64_t getHash();
         private:
-            std::vector<Byte> m_PRG_ROM;
-            std::vector<Byte> m_CHR_ROM;
+            //The whole file, read or mapped. The ROM is never written, so every cartridge of the same game in
+            //the process shares one copy.
+            struct Image
+            {
+                std::vector<Byte> buffer;
+                MappedFile mapping;
+
+                ROMView PRG_ROM;
+                ROMView CHR_ROM;
+            };
+            //Reads or maps the file into image, false if it can't be opened
+            static bool readFile(const std::string& path, bool mapFile, Image& image);
+            //The copy already loaded if the same game is, else image after adding it to the ones shared
+            static std::shared_ptr<const Image> shareImage(std::shared_ptr<const Image> image, std::uint64_t hash);
+
+            std::shared_ptr<const Image> m_image;
             Byte m_nameTableMirroring;
             Byte m_mapperNumber;
             bool m_extendedRAM;
-            bool m_chrRAM;
+            //Hashing reads all of the ROM, which loading a mapped one otherwise doesn't
+            bool m_hashed;
+            std::uint64_t m_hash;
     };
 
 };
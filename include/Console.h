@@ -0,0 +1,183 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "CPU.h"
+#include "PPU.h"
+#include "MainBus.h"
+#include "PictureBus.h"
+#include "Controller.h"
+#include "Scheduler.h"
+#include "Profiler.h"
+#include "SaveState.h"
+#include "SharedState.h"
+#include "RewindBuffer.h"
+#include "Movie.h"
+
+namespace sn
+{
+    const int NESVideoWidth = ScanlineVisibleDots;
+    const int NESVideoHeight = VisibleScanlines;
+
+    //Length of a CPU cycle on an NTSC console
+    const std::chrono::nanoseconds CPUCycleDuration (559);
+
+    //The emulated machine on its own: no window, keyboard or timing. Whoever drives it
+    //sets the buttons, runs it for as long as it likes and picks up the finished frames.
+    class Console
+    {
+    public:
+        Console();
+        //Loads the ROM and powers on, false if it can't be run. mapFile maps the file instead of reading
+        //it, see Cartridge::loadFromFile().
+        bool loadROM(std::string rom_path, bool mapFile = false);
+
+        //Runs for at least the given number of CPU cycles, up to the next instruction boundary.
+        //Returns the cycles actually run, so the excess can be accounted for next time.
+        std::uint64_t runCycles(std::uint64_t cycles);
+        //Runs until the PPU has finished the current frame
+        void runFrame();
+        //Runs for the given number of frames, or until stop (checked after every frame)
+        //returns true. Returns the frames run.
+        int runFrames(int frames, std::function<bool(void)> stop = nullptr);
+        //Runs uncapped for the given number of frames, then writes the emulation speed
+        //and where the time went to out
+        void benchmark(int frames, std::ostream& out);
+
+        //Buttons held on the given controller (0 or 1), bit n is set if Controller::Buttons n is
+        void setButtons(int controller, Byte buttons);
+
+        //Replaces the contents of state with a snapshot of the whole machine, a few dozen KB.
+        //Reusing the same vector for every snapshot avoids allocating.
+        void saveState(std::vector<Byte>& state);
+        //Restores a snapshot taken with the same ROM loaded. False if it's from another ROM or
+        //version, or damaged. Pictures aren't part of it: getFrame() is only updated by the next
+        //frame, which lacks whatever was drawn before the snapshot if it was taken mid-frame.
+        bool loadState(const std::vector<Byte>& state) { return loadState(state.data(), state.size()); }
+        bool loadState(const Byte* data, std::size_t size);
+        //Same, as pages shared with base (e.g. the state this one was loaded from) where equal. Forking
+        //a SharedState is copying it, so this is how to branch off many states from one cheaply.
+        void saveState(SharedState& state, const SharedState* base = nullptr);
+        bool loadState(const SharedState& state);
+
+        //While enabled, a snapshot is added to the rewind buffer after every frame
+        void setRewindEnabled(bool enabled);
+        bool isRewindEnabled() { return m_rewindEnabled; }
+        RewindBuffer& getRewindBuffer() { return m_rewindBuffer; }
+        //Goes back to the end of the frame before the last one, and draws that frame again.
+        //False if there's no history left, or if it can't be loaded, the console stays where it is then.
+        bool rewindFrame();
+
+        //Run-ahead: after every frame, this many more are run with the same input and the last of them is
+        //shown by getFrame(), then the machine goes back. Hides that many frames of the game's own input lag.
+        //Only the shown frame is drawn, so it costs little more than the CPU time of the extra frames.
+        //Turned off if the machine can't be taken back.
+        void setRunAhead(int frames);
+        int getRunAhead() { return m_runAhead; }
+
+        //While disabled, frames are run without being drawn (about three times faster), getFrame() keeps
+        //the last one drawn. Nothing the game can observe changes, so it can be toggled between any
+        //two frames, e.g. to only draw every nth one.
+        void setVideoEnabled(bool enabled);
+        bool isVideoEnabled() { return m_videoEnabled; }
+
+        //While a movie is recorded or played, input only changes between frames: buttons set during a
+        //frame are taken from the next one. Recording starts from the current state and keeps the input
+        //of every frame, frames undone by rewinding are dropped from it.
+        void recordMovie(Movie& movie);
+        //Restores the movie's start state and plays its input until all of its frames have been run,
+        //the buttons set meanwhile are ignored. False if the movie is for another ROM.
+        bool playMovie(Movie& movie);
+        void stopMovie();
+        bool isRecordingMovie() { return m_movieMode == RecordingMovie; }
+        bool isPlayingMovie() { return m_movieMode == PlayingMovie; }
+
+        //The last complete frame, NESVideoWidth x NESVideoHeight RGBA pixels (0xRRGGBBAA) row by row
+        const std::vector<std::uint32_t>& getFrame() { return m_ppu.getFrame(); }
+        //The same frame as NES palette colors, one byte per pixel, and the color emphasis of each line.
+        //A quarter of the size and nothing to convert, for whoever has its own palette or wants it small.
+        const std::vector<Byte>& getPaletteFrame() { return m_ppu.getPaletteFrame(); }
+        const std::vector<Byte>& getEmphasis() { return m_ppu.getEmphasis(); }
+        //Number of frames completed since power on
+        std::uint64_t getFrameCount() { return m_ppu.getFrameCount(); }
+        //Writes the last frame as a binary PPM image
+        bool dumpFrame(const std::string& path);
+        //Writes the 2KB of internal RAM as raw bytes
+        bool dumpRAM(const std::string& path);
+        const std::vector<Byte>& getRAM() { return m_bus.getRAM(); }
+    private:
+        void DMA(Byte page);
+
+        //Master clock time at which the next CPU instruction starts
+        Timestamp clock() { return (m_cpu.getCycles() + 1) * 3; }
+        //Runs the CPU until the next instruction would start at or after the given time.
+        //The PPU is only caught up when a scheduled event is due or the CPU accesses it.
+        void runUntil(Timestamp time);
+        void syncPPU(Timestamp time);
+        //Schedules the next PPU events according to its current state
+        void schedulePPUEvents();
+        //Called on every scheduled event, records for rewinding and runs ahead once a frame has been completed
+        void checkFrameEnd();
+        void runAhead();
+        //Records or plays the input of the frame just started
+        void updateMovie();
+        //Checks the header of a save state of the given size, then load the rest of it. readState() is false
+        //if the state is damaged, the machine is only partly loaded then.
+        bool readStateHeader(StateReader& state, std::size_t size);
+        bool readState(StateReader& state);
+
+        MainBus m_bus;
+        PictureBus m_pictureBus;
+        CPU m_cpu;
+        PPU m_ppu;
+        Cartridge m_cartridge;
+        std::unique_ptr<Mapper> m_mapper;
+
+        Scheduler m_scheduler;
+        //Master clock time the PPU has been run up to
+        Timestamp m_ppuClock;
+
+        Profiler m_profiler;
+
+        Controller m_controller1, m_controller2;
+
+        //Frame count when checkFrameEnd() last saw a frame end, or when a state was loaded
+        std::uint64_t m_lastFrame;
+        //Running frames that will be undone, rewinding or running ahead
+        bool m_speculating;
+
+        bool m_rewindEnabled;
+        RewindBuffer m_rewindBuffer;
+        std::vector<Byte> m_rewindState;
+
+        bool m_videoEnabled;
+        int m_runAhead;
+        std::vector<Byte> m_runAheadState;
+
+        //Contiguous copy of SharedStates being saved or loaded
+        std::vector<Byte> m_sharedStateBuffer;
+        //The machine before a load, put back if the load fails
+        std::vector<Byte> m_loadBackup;
+
+        enum MovieMode
+        {
+            NoMovie,
+            RecordingMovie,
+            PlayingMovie,
+        } m_movieMode;
+        Movie* m_movie;
+        //Frame count at the first frame of the movie
+        std::uint64_t m_movieStart;
+        //Time the current frame started, buttons set right then still count for it
+        Timestamp m_frameStart;
+        //Buttons last set, while recording they're taken at the start of the next frame
+        Movie::Input m_buttons;
+    };
+}
+#endif // CONSOLE_H
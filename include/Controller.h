@@ -1,8 +1,7 @@
 #ifndef CONTROLLER_H
 #define CONTROLLER_H
-#include <SFML/Window.hpp>
 #include <cstdint>
-#include <vector>
+#include "SaveState.h"
 
 namespace sn
 {
@@ -26,13 +25,16 @@ namespace sn
 
         void strobe(Byte b);
         Byte read();
-        void setKeyBindings(const std::vector<sf::Keyboard::Key>& keys);
+        //Buttons currently held, bit n is set if button n (see Buttons) is. None until set.
+        void setButtons(Byte buttons);
+        Byte getButtons() { return m_buttons; }
+
+        void saveState(StateWriter& state);
+        void loadState(StateReader& state);
     private:
         bool m_strobe;
         unsigned int m_keyStates;
-
-        std::vector<sf::Keyboard::Key> m_keyBindings;
-//         sf::Keyboard::Key m_keyBindings[TotalButtons];
+        Byte m_buttons;
     };
 }
 
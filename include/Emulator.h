@@ -1,21 +1,22 @@
 #ifndef EMULATOR_H
 #define EMULATOR_H
 #include <SFML/Graphics.hpp>
+#include <atomic>
 #include <chrono>
+#include <thread>
 
-#include "CPU.h"
-#include "PPU.h"
-#include "MainBus.h"
-#include "PictureBus.h"
-#include "Controller.h"
+#include "Console.h"
+#include "Movie.h"
+#include "TripleBuffer.h"
+#include "VirtualScreen.h"
 
 namespace sn
 {
     using TimePoint = std::chrono::high_resolution_clock::time_point;
 
-    const int NESVideoWidth = ScanlineVisibleDots;
-    const int NESVideoHeight = VisibleScanlines;
-
+    //Window, keyboard and real time pacing around the Console. The Console runs on a thread of its own
+    //paced by the clock, the window's thread handles events and shows the latest frame at the display's
+    //rate, so waiting for vsync never holds up the game. Hold tab to fast-forward.
     class Emulator
     {
     public:
@@ -24,27 +25,49 @@ namespace sn
         void setVideoWidth(int width);
         void setVideoHeight(int height);
         void setVideoScale(float scale);
+        //History kept for rewinding (hold backspace), 0 turns it off. More frequent keyframes take more memory.
+        void setRewindMemory(std::size_t bytes);
+        void setRewindKeyframeInterval(int frames);
+        //See Console::setRunAhead()
+        void setRunAhead(int frames);
+        //Records the input from the start into a movie, saved to the given file on exit
+        void setMovieRecording(const std::string& path);
         void setKeys(std::vector<sf::Keyboard::Key>& p1, std::vector<sf::Keyboard::Key>& p2);
     private:
-        void DMA(Byte page);
-
-        MainBus m_bus;
-        PictureBus m_pictureBus;
-        CPU m_cpu;
-        PPU m_ppu;
-        Cartridge m_cartridge;
-        std::unique_ptr<Mapper> m_mapper;
+        //Buttons of the bound keys held down, as Console::setButtons takes them
+        Byte readKeys(const std::vector<sf::Keyboard::Key>& keys);
+        //The emulation thread, runs the Console until m_running is cleared
+        void emulate();
+        //Hands the last frame to the window's thread if a new one is done
+        void publishFrame();
 
-        Controller m_controller1, m_controller2;
+        Console m_console;
+        Movie m_movie;
+        std::string m_moviePath;
+        std::vector<sf::Keyboard::Key> m_p1Keys, m_p2Keys;
 
         sf::RenderWindow m_window;
         VirtualScreen m_emulatorScreen;
         float m_screenScale;
+        std::uint64_t m_shownFrame;
 
         TimePoint m_cycleTimer;
 
         std::chrono::high_resolution_clock::duration m_elapsedTime;
         std::chrono::nanoseconds m_cpuCycleDuration;
+
+        //Shared by the emulation thread and the window's thread
+        std::thread m_emulation;
+        TripleBuffer<std::vector<std::uint32_t>> m_frames;
+        std::atomic<bool> m_running;
+        //Pausing is logged by the emulation thread, the only one writing to the log while it runs
+        std::atomic<bool> m_paused;
+        std::atomic<bool> m_focused;
+        std::atomic<bool> m_rewinding;
+        std::atomic<bool> m_fastForward;
+        //Frames to run while paused, one per F3
+        std::atomic<int> m_framesToStep;
+        std::atomic<Byte> m_buttons[2];
     };
 }
 #endif // EMULATOR_H
@@ -1,5 +1,6 @@
 #ifndef LOG_H
 #define LOG_H
+#include <atomic>
 #include <iostream>
 #include <string>
 #include <fstream>
@@ -28,9 +29,12 @@ namespace sn
         InfoVerbose,
         CpuTrace
     };
+    //Where LOG and LOG_CPU write to. There's one for the whole process, a thread can write to its own
+    //instead (e.g. one per Console when many run at once, see Runner).
     class Log
     {
     public:
+        Log();
         ~Log();
         void setLogStream(std::ostream& stream);
         void setCpuTraceStream(std::ostream& stream);
@@ -40,9 +44,14 @@ namespace sn
         std::ostream& getStream();
         std::ostream& getCpuTraceStream();
 
+        //The log of the calling thread: the one set with setCurrent(), or else the one of the process
         static Log& get();
+        //Makes the calling thread log to the given log, nullptr goes back to the one of the process.
+        //Returns the one set before.
+        static Log* setCurrent(Log* log);
     private:
-        Level m_logLevel;
+        //May be changed while other threads log
+        std::atomic<Level> m_logLevel;
         std::ostream* m_logStream;
         std::ostream* m_cpuTrace;
     };
@@ -1,11 +1,14 @@
 #ifndef MEMORY_H
 #define MEMORY_H
 #include <vector>
+#include <array>
 #include <unordered_map>
 #include <functional>
 #include <memory>
 #include "Cartridge.h"
 #include "Mapper.h"
+#include "Profiler.h"
+#include "SaveState.h"
 
 namespace sn
 {
@@ -31,20 +34,64 @@ namespace sn
         }
     };
 
+    class PPU;
+    class Controller;
+
     class MainBus
     {
         public:
             MainBus();
-            Byte read(Address addr);
-            void write(Address addr, Byte value);
+            //Plain memory is accessed directly through the page tables, everything else goes the slow way
+            Byte read(Address addr)
+            {
+                auto page = m_readPages[addr >> 8];
+                return page ? page[addr & 0xff] : readIO(addr);
+            }
+            void write(Address addr, Byte value)
+            {
+                auto page = m_writePages[addr >> 8];
+                if (page)
+                    page[addr & 0xff] = value;
+                else
+                    writeIO(addr, value);
+            }
             bool setMapper(Mapper* mapper);
             bool setWriteCallback(IORegisters reg, std::function<void(Byte)> callback);
             bool setReadCallback(IORegisters reg, std::function<Byte(void)> callback);
+            //Binds the registers of these devices directly, so they don't go through the callbacks.
+            //Callbacks are still used for every register that isn't bound this way.
+            void setPPU(PPU* ppu);
+            void setControllers(Controller* controller1, Controller* controller2);
+            //Called before every access the PPU can observe (its registers, OAM DMA and
+            //mapper writes) so it can be caught up with the CPU first
+            void setSyncCallback(std::function<void(void)> callback);
+            //Time spent in mapper register writes is added to it
+            void setProfiler(Profiler* profiler);
             const Byte* getPagePtr(Byte page);
+            const std::vector<Byte>& getRAM() { return m_RAM; }
+
+            //The mapper has to be loaded first, the PRG pages are pointed to its banks again
+            void saveState(StateWriter& state);
+            void loadState(StateReader& state);
         private:
+            Byte readIO(Address addr);
+            void writeIO(Address addr, Byte value);
+            //Points the pages of PRG ROM to whatever banks the mapper has selected
+            void mapPRG();
+
             std::vector<Byte> m_RAM;
             std::vector<Byte> m_extRAM;
             Mapper* m_mapper;
+            PPU* m_ppu;
+            Controller* m_controller1;
+            Controller* m_controller2;
+
+            std::function<void(void)> m_syncCallback;
+            Profiler* m_profiler;
+
+            //One entry for every 256 byte page of the address space, nullptr if it isn't plain memory
+            std::array<const Byte*, 0x100> m_readPages;
+            std::array<Byte*, 0x100> m_writePages;
 
             std::unordered_map<IORegisters, std::function<void(Byte)>, IORegistersHasher> m_writeCallbacks;
             std::unordered_map<IORegisters, std::function<Byte(void)>, IORegistersHasher> m_readCallbacks;;
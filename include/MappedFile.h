@@ -0,0 +1,31 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+#include <cstdint>
+#include <string>
+
+namespace sn
+{
+    //A file mapped read-only into memory. Nothing is read until touched, and the memory is the page cache's,
+    //shared with every other process mapping the file. The file mustn't change while mapped.
+    class MappedFile
+    {
+        public:
+            MappedFile();
+            ~MappedFile();
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            //False if it can't be mapped: it can't be opened, it's empty or mapping isn't supported here
+            bool open(const std::string& path);
+            void close();
+
+            bool isOpen() const { return m_data != nullptr; }
+            const std::uint8_t* data() const { return static_cast<const std::uint8_t*>(m_data); }
+            std::size_t size() const { return m_size; }
+        private:
+            void* m_data;
+            std::size_t m_size;
+    };
+}
+
+#endif // MAPPEDFILE_H
@@ -2,8 +2,11 @@
 #define MAPPER_H
 #include "CPUOpcodes.h"
 #include "Cartridge.h"
+#include "SaveState.h"
 #include <memory>
+#include <array>
 #include <functional>
+#include <vector>
 
 namespace sn
 {
@@ -32,14 +35,20 @@ namespace sn
                 GxROM = 66,
             };
 
-            Mapper(Cartridge& cart, Type t) : m_cartridge(cart), m_type(t) {};
+            Mapper(Cartridge& cart, Type t) : m_cartridge(cart), m_type(t), m_prgPages(), m_chrPages() {};
             virtual ~Mapper() = default;
             virtual void writePRG (Address addr, Byte value) = 0;
-            virtual Byte readPRG (Address addr) = 0;
+            //Reads through the page tables below, only mappers with side effecting reads override these
+            virtual Byte readPRG (Address addr);
 
-            virtual Byte readCHR (Address addr) = 0;
+            virtual Byte readCHR (Address addr);
             virtual void writeCHR (Address addr, Byte value) = 0;
 
+            //The 8KB page of PRG (from 0x8000) and the 1KB page of CHR that addr currently falls in.
+            //The buses read through these directly, nullptr means they have to call readPRG()/readCHR().
+            const Byte* getPRGPage(Address addr) { return m_prgPages[(addr >> 13) & 0x3]; }
+            const Byte* getCHRPage(Address addr) { return m_chrPages[(addr >> 10) & 0x7]; }
+
             virtual NameTableMirroring getNameTableMirroring();
 
             bool inline hasExtendedRAM()
@@ -48,12 +57,31 @@ namespace sn
             }
 
             virtual void scanlineIRQ(){}
+            //Whether scanlineIRQ() may currently raise an interrupt
+            virtual bool scanlineIRQEnabled() { return false; }
+
+            //Registers and memory of the mapper, including which banks are selected.
+            //Subclasses with state of their own extend these and call them first.
+            virtual void saveState(StateWriter& state);
+            virtual void loadState(StateReader& state);
 
+            //Whether createMapper() can create the type
+            static bool isSupported(Type mapper_t);
             static std::unique_ptr<Mapper> createMapper (Type mapper_t, Cartridge& cart, std::function<void()> interrupt_cb, std::function<void(void)> mirroring_cb);
 
         protected:
+            //Points count consecutive pages, starting with the page number first, to the memory at bank.
+            //Mappers call these whenever they switch banks.
+            void mapPRG(int first, int count, const Byte* bank);
+            void mapCHR(int first, int count, const Byte* bank);
+
             Cartridge& m_cartridge;
             Type m_type;
+
+            std::array<const Byte*, 4> m_prgPages;
+            std::array<const Byte*, 8> m_chrPages;
+            //CHR RAM of the cartridges that have it instead of CHR ROM, mapped page for page
+            std::vector<Byte> m_characterRAM;
     };
 }
 
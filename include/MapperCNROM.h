@@ -9,10 +9,11 @@ namespace sn
         public:
             MapperCNROM(Cartridge& cart);
             void writePRG (Address addr, Byte value);
-            Byte readPRG (Address addr);
 
-            Byte readCHR (Address addr);
             void writeCHR (Address addr, Byte value);
+
+            void saveState(StateWriter& state);
+            void loadState(StateReader& state);
         private:
             bool m_oneBank;
 
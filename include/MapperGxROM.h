@@ -8,10 +8,12 @@ namespace sn
         MapperGxROM(Cartridge &cart, std::function<void(void)> mirroring_cb);
         NameTableMirroring getNameTableMirroring();
         void writePRG(Address address, Byte value);
-        Byte readPRG(Address address);
 
-        Byte readCHR(Address address);
         void writeCHR(Address address, Byte value);
+
+        void saveState(StateWriter& state);
+        void loadState(StateReader& state);
+
         Byte prgbank;
         Byte chrbank;
 
@@ -19,7 +21,6 @@ namespace sn
     private:
         NameTableMirroring m_mirroring;
 
-        std::vector<Byte> m_characterRAM;
         std::function<void(void)> m_mirroringCallback;
 
     };
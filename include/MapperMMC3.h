@@ -10,7 +10,6 @@ namespace sn
   public:
     MapperMMC3(Cartridge &cart, std::function<void()> interrupt_cb, std::function<void(void)> mirroring_cb);
 
-    Byte readPRG(Address addr);
     void writePRG(Address addr, Byte value);
 
     NameTableMirroring getNameTableMirroring();
@@ -18,8 +17,14 @@ namespace sn
     void writeCHR(Address addr, Byte value);
 
     void scanlineIRQ();
+    bool scanlineIRQEnabled() { return m_irqEnabled; }
+
+    void saveState(StateWriter& state);
+    void loadState(StateReader& state);
 
   private:
+    void updateCHRPages();
+
     // Control variables
     uint32_t m_targetRegister;
     bool m_prgBankMode;
@@ -34,11 +39,6 @@ namespace sn
 
     std::vector<Byte> m_prgRam;
     std::vector<Byte> m_mirroringRam;
-    const Byte *m_prgBank0;
-    const Byte *m_prgBank1;
-    const Byte *m_prgBank2;
-    const Byte *m_prgBank3;
-
     std::array<uint32_t, 8> m_chrBanks;
 
     NameTableMirroring m_mirroring;
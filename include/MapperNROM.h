@@ -9,16 +9,15 @@ namespace sn
         public:
             MapperNROM(Cartridge& cart);
             void writePRG (Address addr, Byte value);
-            Byte readPRG (Address addr);
 
-            Byte readCHR (Address addr);
             void writeCHR (Address addr, Byte value);
+
+            void saveState(StateWriter& state);
+            void loadState(StateReader& state);
         private:
             bool m_oneBank;
             bool m_usesCharacterRAM;
 
-            std::vector<Byte> m_characterRAM;
-
     };
 }
 #endif // MAPPERNROM_H
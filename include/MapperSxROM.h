@@ -9,14 +9,16 @@ namespace sn
         public:
             MapperSxROM(Cartridge& cart, std::function<void(void)> mirroring_cb);
             void writePRG (Address addr, Byte value);
-            Byte readPRG (Address addr);
 
-            Byte readCHR (Address addr);
             void writeCHR (Address addr, Byte value);
 
             NameTableMirroring getNameTableMirroring();
+
+            void saveState(StateWriter& state);
+            void loadState(StateReader& state);
         private:
             void calculatePRGPointers();
+            void updateCHRPages();
 
             std::function<void(void)> m_mirroringCallback;
             NameTableMirroring m_mirroing;
@@ -38,7 +40,6 @@ namespace sn
             const Byte* m_firstBankCHR;
             const Byte* m_secondBankCHR;
 
-            std::vector<Byte> m_characterRAM;
     };
 }
 #endif // MAPPERSXROM_H
@@ -9,18 +9,17 @@ namespace sn
         public:
             MapperUxROM(Cartridge& cart);
             void writePRG (Address addr, Byte value);
-            Byte readPRG (Address addr);
 
-            Byte readCHR (Address addr);
             void writeCHR (Address addr, Byte value);
+
+            void saveState(StateWriter& state);
+            void loadState(StateReader& state);
         private:
             bool m_usesCharacterRAM;
 
             const Byte* m_lastBankPtr;
             Address m_selectPRG;
 
-            std::vector<Byte> m_characterRAM;
-
     };
 }
 #endif // MAPPERUXROM_H
@@ -0,0 +1,43 @@
+#ifndef MOVIE_H
+#define MOVIE_H
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sn
+{
+    //Controller input of a run, frame by frame, along with the state it started from and the ROM it's for.
+    //Played back from that state, it reproduces the run exactly.
+    class Movie
+    {
+        public:
+            //Buttons of both controllers during one frame, as Console::setButtons takes them
+            using Input = std::array<std::uint8_t, 2>;
+
+            Movie();
+            bool loadFromFile(const std::string& path);
+            bool saveToFile(const std::string& path);
+
+            //Cartridge::getHash() of the ROM it's for
+            std::uint64_t getROMHash() { return m_romHash; }
+            void setROMHash(std::uint64_t hash) { m_romHash = hash; }
+            //Console::saveState() at the first frame
+            const std::vector<std::uint8_t>& getStartState() { return m_startState; }
+            void setStartState(const std::vector<std::uint8_t>& state) { m_startState = state; }
+
+            std::size_t getLength() { return m_inputs.size(); }
+            const Input& getInput(std::size_t frame) { return m_inputs[frame]; }
+            //Sets the input of the given frame, dropping any after it
+            void setInput(std::size_t frame, const Input& input);
+            //Drops the input from the given frame on
+            void truncate(std::size_t frames) { m_inputs.resize(std::min(frames, m_inputs.size())); }
+        private:
+            std::uint64_t m_romHash;
+            std::vector<std::uint8_t> m_startState;
+            std::vector<Input> m_inputs;
+    };
+}
+
+#endif // MOVIE_H
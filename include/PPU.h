@@ -2,10 +2,12 @@
 #define PPU_H
 #include <functional>
 #include <array>
+#include <cstdint>
+#include <vector>
 #include "PictureBus.h"
 #include "MainBus.h"
-#include "VirtualScreen.h"
 #include "PaletteColors.h"
+#include "SaveState.h"
 
 namespace sn
 {
@@ -20,12 +22,37 @@ namespace sn
     class PPU
     {
         public:
-            PPU(PictureBus &bus, VirtualScreen &screen);
+            PPU(PictureBus &bus);
             void step();
+            //Advances the PPU by the given number of dots
+            void run(int dots);
             void reset();
 
+            //Dots left until the PPU raises the vblank NMI, finishes the frame and clocks the
+            //mapper's scanline counter. Never late, but may be a dot early before the pre-render
+            //line is over, since it's a dot shorter on odd frames. -1 if the counter isn't clocked.
+            int dotsUntilVBlank();
+            int dotsUntilFrameEnd();
+            int dotsUntilScanlineIRQ();
+            //Number of frames completed since reset
+            std::uint64_t getFrameCount() { return m_frameCount; }
+            //The last complete frame as colors of the NES palette (0 to 63), one byte per pixel row by row
+            const std::vector<Byte>& getPaletteFrame() { return m_frame; }
+            //Color emphasis (PPUMASK bits 5 to 7, shifted down) of each scanline of the last complete frame
+            const std::vector<Byte>& getEmphasis() { return m_frameEmphasis; }
+            //The last complete frame, RGBA pixels (0xRRGGBBAA) row by row. Converted from the palette colors
+            //the first time it's asked for after each frame.
+            const std::vector<std::uint32_t>& getFrame();
+            //Without output no pixels are drawn, which saves most of the rendering time.
+            //Everything the CPU can observe, like the sprite 0 hit, still happens.
+            void setOutputEnabled(bool enabled) { m_outputEnabled = enabled; }
+
             void setInterruptCallback(std::function<void(void)> cb);
 
+            //The pictures aren't part of the state, the next frame is drawn over them anyway
+            void saveState(StateWriter& state);
+            void loadState(StateReader& state);
+
             void doDMA(const Byte* page_ptr);
 
             //Callbacks mapped to CPU address space
@@ -45,8 +72,15 @@ namespace sn
             Byte readOAM(Byte addr);
             void writeOAM(Byte addr, Byte value);
             Byte read(Address addr);
+            //Dots from the current one on that step() would only count, 0 if it has something to do
+            int idleDots();
+            //Draws pixels [x, end) of the current scanline, fetching each tile once, and moves the
+            //address along as the visible dots of the scanline would
+            void render(int x, int end);
+            //Dots until the given dot of a post-render or vblank scanline
+            int dotsUntil(int scanline, int cycle);
             PictureBus &m_bus;
-            VirtualScreen &m_screen;
+            bool m_outputEnabled;
 
             std::function<void(void)> m_vblankCallback;
 
@@ -64,6 +98,7 @@ namespace sn
             int m_cycle;
             int m_scanline;
             bool m_evenFrame;
+            std::uint64_t m_frameCount;
 
             bool m_vblank;
             bool m_sprZeroHit;
@@ -83,6 +118,7 @@ namespace sn
             bool m_generateInterrupt;
 
             bool m_greyscaleMode;
+            Byte m_emphasis;
             bool m_showSprites;
             bool m_showBackground;
             bool m_hideEdgeSprites;
@@ -97,7 +133,15 @@ namespace sn
 
             Address m_dataAddrIncrement;
 
-            std::vector<std::vector<sf::Color>> m_pictureBuffer;
+            //Frame being drawn and the last complete one with the emphasis of their lines, swapped at the
+            //end of each frame
+            std::vector<Byte> m_pictureBuffer;
+            std::vector<Byte> m_frame;
+            std::vector<Byte> m_emphasisBuffer;
+            std::vector<Byte> m_frameEmphasis;
+            //m_frame in RGBA, unless converting it is pending
+            std::vector<std::uint32_t> m_rgbaFrame;
+            bool m_rgbaPending;
     };
 }
 
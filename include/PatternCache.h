@@ -0,0 +1,67 @@
+#ifndef PATTERNCACHE_H
+#define PATTERNCACHE_H
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace sn
+{
+    //A row of a tile's 8 pixels, 2 bits each combined from its two bit planes, the leftmost pixel in
+    //the lowest bits. flipped has them the other way round, for sprites flipped horizontally.
+    struct PatternRow
+    {
+        std::uint16_t pixels;
+        std::uint16_t flipped;
+    };
+
+    //Tiles of the 1KB CHR pages the PPU draws from, decoded into PatternRows the first time they're
+    //drawn. Pages are told apart by where the mapper maps them from, so switching banks needs nothing
+    //but writes to CHR RAM have to invalidate the tile written.
+    class PatternCache
+    {
+        public:
+            PatternCache();
+
+            //Row of the tile at offset into page (tile * 16 + row), decoding the tile if it isn't yet
+            PatternRow getRow(const std::uint8_t* page, std::size_t offset)
+            {
+                auto& slot = getSlot(page);
+                if (slot.page != page)
+                {
+                    slot.page = page;
+                    slot.decoded = 0;
+                }
+                auto tile = offset >> 4;
+                if (!((slot.decoded >> tile) & 1))
+                    decodeTile(slot, tile);
+                return slot.rows[tile * 8 + (offset & 7)];
+            }
+            //The tile with the byte at offset into page is decoded again the next time
+            void invalidate(const std::uint8_t* page, std::size_t offset);
+            //Forgets every page, their memory may be reused for something else
+            void clear();
+
+            static PatternRow decode(std::uint8_t low, std::uint8_t high);
+        private:
+            struct Slot
+            {
+                const std::uint8_t* page;
+                //Bit n is set if tile n of the page is decoded
+                std::uint64_t decoded;
+                std::array<PatternRow, 64 * 8> rows;
+            };
+
+            //Twice the pages mapped at once, so banks switched back and forth mid-frame stay decoded
+            static const std::size_t Slots = 16;
+
+            Slot& getSlot(const std::uint8_t* page)
+            {
+                return m_slots[(reinterpret_cast<std::uintptr_t>(page) >> 10) % Slots];
+            }
+            void decodeTile(Slot& slot, std::size_t tile);
+
+            std::vector<Slot> m_slots;
+    };
+}
+
+#endif // PATTERNCACHE_H
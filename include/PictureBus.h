@@ -3,6 +3,8 @@
 #include <vector>
 #include "Cartridge.h"
 #include "Mapper.h"
+#include "PatternCache.h"
+#include "SaveState.h"
 
 namespace sn
 {
@@ -12,11 +14,17 @@ namespace sn
             PictureBus();
             Byte read(Address addr);
             void write(Address addr, Byte value);
+            //The pattern row with its first bit plane at addr, decoded from the cache where possible
+            PatternRow readPattern(Address addr);
 
             bool setMapper(Mapper *mapper);
             Byte readPalette(Byte paletteAddr);
             void updateMirroring();
             void scanlineIRQ();
+
+            //The mapper has to be loaded first, the name tables are mirrored according to it
+            void saveState(StateWriter& state);
+            void loadState(StateReader& state);
         private:
             std::size_t NameTable0, NameTable1, NameTable2, NameTable3; //indices where they start in RAM vector
 
@@ -24,6 +32,7 @@ namespace sn
 
             std::vector<Byte> m_RAM;
             Mapper* m_mapper;
+            PatternCache m_patterns;
     };
 }
 #endif // PICTUREBUS_H
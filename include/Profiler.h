@@ -0,0 +1,43 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+#include <array>
+#include <chrono>
+
+namespace sn
+{
+    //Accumulates the time spent in parts of the emulator, only while enabled
+    class Profiler
+    {
+        public:
+            enum Section
+            {
+                PPU,
+                Mapper,
+                TotalSections,
+            };
+            using Clock = std::chrono::steady_clock;
+
+            Profiler();
+            void setEnabled(bool enabled) { m_enabled = enabled; }
+            bool isEnabled() { return m_enabled; }
+            void reset();
+            std::chrono::nanoseconds getTime(Section section) { return m_times[section]; }
+
+            //Adds the time between its construction and destruction to the section
+            class Scope
+            {
+                public:
+                    Scope(Profiler* profiler, Section section);
+                    ~Scope();
+                private:
+                    Profiler* m_profiler;
+                    Section m_section;
+                    Clock::time_point m_start;
+            };
+        private:
+            bool m_enabled;
+            std::array<std::chrono::nanoseconds, TotalSections> m_times;
+    };
+}
+
+#endif // PROFILER_H
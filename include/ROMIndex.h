@@ -0,0 +1,69 @@
+#ifndef ROMINDEX_H
+#define ROMINDEX_H
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "Cartridge.h"
+#include "MappedFile.h"
+
+namespace sn
+{
+    //The headers and hashes of every .nes image under a directory, in a file meant to be mapped and used as is:
+    //a small header, the entries sorted by hash and the paths they're at. Building one reads the images on
+    //several threads, so it goes as fast as the disk.
+    class ROMIndex
+    {
+        public:
+            enum Flags : Byte
+            {
+                //Has an iNES header, the rest of the fields are only set if so
+                Valid       = 1 << 0,
+                //Cartridge::isSupported(), i.e. it can be run
+                Supported   = 1 << 1,
+                NES2        = 1 << 2,
+                Trainer     = 1 << 3,
+                ExtendedRAM = 1 << 4,
+            };
+
+            //32 bytes, laid out the same in the file
+            struct Entry
+            {
+                //Cartridge::getHash() of the image, 0 if it isn't valid
+                std::uint64_t hash;
+                //Of the path relative to the directory scanned, see getPath()
+                std::uint32_t pathOffset;
+                std::uint32_t fileSize;
+                std::uint16_t mapper;
+                std::uint16_t prgBanks;
+                std::uint16_t chrBanks;
+                Byte nameTableMirroring;
+                //ROMHeader::Region
+                Byte region;
+                Byte flags;
+                Byte reserved[7];
+            };
+
+            //Scans directory and everything under it, writing the index of the .nes files found to indexPath.
+            //0 threads uses one per core. Prints how it went to out if given.
+            static bool build(const std::string& directory, const std::string& indexPath,
+                              unsigned threads = 0, std::ostream* out = nullptr);
+
+            ROMIndex();
+            //Maps an index built before, false if it can't or it isn't one
+            bool load(const std::string& indexPath);
+            std::size_t size() { return m_size; }
+            const Entry& getEntry(std::size_t index) { return m_entries[index]; }
+            //Path of the entry's image, relative to the directory scanned
+            const char* getPath(const Entry& entry) { return m_paths + entry.pathOffset; }
+            //The first entry with the hash, nullptr if none (copies of an image have the same hash)
+            const Entry* find(std::uint64_t hash);
+        private:
+            MappedFile m_file;
+            const Entry* m_entries;
+            std::size_t m_size;
+            const char* m_paths;
+    };
+}
+
+#endif // ROMINDEX_H
@@ -0,0 +1,58 @@
+#ifndef REWINDBUFFER_H
+#define REWINDBUFFER_H
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace sn
+{
+    //History of save states, newest last. Every keyframeInterval-th one is kept whole, the ones in between
+    //only as the bytes that differ from their keyframe (XORed, with runs of equal bytes skipped), which are
+    //usually a few hundred. The oldest states are dropped, a keyframe with its deltas at a time, to stay
+    //within the memory limit.
+    class RewindBuffer
+    {
+        public:
+            RewindBuffer(std::size_t memoryLimit = 8 * 1024 * 1024, int keyframeInterval = 60);
+
+            //More memory keeps more history, more frequent keyframes make the deltas smaller
+            void setMemoryLimit(std::size_t bytes);
+            void setKeyframeInterval(int frames);
+            std::size_t getMemoryLimit() { return m_memoryLimit; }
+            int getKeyframeInterval() { return m_keyframeInterval; }
+
+            void push(const std::vector<std::uint8_t>& state);
+            //Copies the state age steps back from the newest (0) to state, false if there's none that old
+            bool get(std::size_t age, std::vector<std::uint8_t>& state);
+            //Forgets the newest count states
+            void drop(std::size_t count);
+            void clear();
+
+            //Number of states kept and the memory they take
+            std::size_t size() { return m_entries.size(); }
+            std::size_t getMemoryUsed() { return m_memoryUsed; }
+        private:
+            struct Entry
+            {
+                bool keyframe;
+                std::vector<std::uint8_t> data;
+            };
+
+            void encodeDelta(const std::vector<std::uint8_t>& keyframe, const std::vector<std::uint8_t>& state);
+            static void decodeDelta(const std::vector<std::uint8_t>& delta, std::vector<std::uint8_t>& state);
+            //Drops the oldest keyframe and its deltas until within the limit, always keeping the newest one
+            void enforceLimit();
+
+            std::deque<Entry> m_entries;
+            //Index of the newest keyframe in m_entries
+            std::size_t m_lastKeyframe;
+            std::size_t m_memoryUsed;
+
+            std::size_t m_memoryLimit;
+            int m_keyframeInterval;
+
+            std::vector<std::uint8_t> m_scratch;
+    };
+}
+
+#endif // REWINDBUFFER_H
@@ -0,0 +1,90 @@
+#ifndef RUNNER_H
+#define RUNNER_H
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Console.h"
+#include "Log.h"
+
+namespace sn
+{
+    //Runs many independent Consoles at once on a pool of threads, to use every core from one process.
+    //Every worker has its own queue and is given the same instances each run, so their state stays in
+    //its core's cache. Only once its own queue is empty does a worker take instances from the others'.
+    class Runner
+    {
+        public:
+            //Buttons of both controllers for an instance's frame (as numbered by Console::getFrameCount()),
+            //called right before the frame on the thread running the instance
+            using InputSource = std::function<Movie::Input(std::size_t instance, std::uint64_t frame)>;
+            //Work done on one instance, on the thread running it
+            using Job = std::function<void(std::size_t instance, Console& console)>;
+
+            //0 threads starts one per core
+            explicit Runner(unsigned threads = 0);
+            ~Runner();
+
+            //Loads the ROM into a new instance with its own log, writing to the given stream at the level
+            //of the calling thread's log (or nowhere if null). False if the ROM couldn't be loaded.
+            bool addInstance(const std::string& romPath, std::ostream* log = nullptr, bool mapFile = false);
+            std::size_t getInstanceCount() { return m_instances.size(); }
+            Console& getConsole(std::size_t instance) { return m_instances[instance]->console; }
+            Log& getLog(std::size_t instance) { return m_instances[instance]->log; }
+            unsigned getThreadCount() { return m_workers.size(); }
+
+            //Without one, the buttons stay as last set on each Console
+            void setInputSource(InputSource input) { m_input = input; }
+            //Runs every instance for the given number of frames, returns once all are done
+            void runFrames(int frames);
+            //Does the job on every instance, returns once all are done
+            void forEach(const Job& job);
+            //Runs every instance for the given number of frames as fast as possible, then prints the speed
+            void benchmark(int frames, std::ostream& out);
+        private:
+            struct Instance
+            {
+                Console console;
+                Log log;
+            };
+            struct Worker
+            {
+                Worker() : front(0) {}
+
+                std::thread thread;
+                std::mutex mutex;
+                //Instances from front on are still to be run. Refilled every run, which doesn't allocate
+                //once it has grown to size.
+                std::vector<std::size_t> queue;
+                std::size_t front;
+            };
+
+            void work(std::size_t worker);
+            //Takes the next instance from the worker's own queue, or else one from the back of another's.
+            //False if all are empty.
+            bool takeInstance(std::size_t worker, std::size_t& instance);
+            void runInstance(std::size_t instance);
+
+            std::vector<std::unique_ptr<Instance>> m_instances;
+            std::vector<std::unique_ptr<Worker>> m_workers;
+            InputSource m_input;
+            //Job of the current run
+            const Job* m_job;
+
+            std::mutex m_mutex;
+            std::condition_variable m_runStarted, m_runDone;
+            //Counts the runs started, workers wake up when it changes
+            std::uint64_t m_run;
+            //Instances not done yet in the current run
+            std::size_t m_remaining;
+            bool m_stop;
+    };
+}
+
+#endif // RUNNER_H
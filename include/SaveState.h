@@ -0,0 +1,88 @@
+#ifndef SAVESTATE_H
+#define SAVESTATE_H
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace sn
+{
+    //"SNST" at the start of every save state
+    const std::uint32_t SaveStateMagic = 0x54534e53;
+    //Bumped whenever anything is added to, removed from or reordered in a save state
+    const std::uint32_t SaveStateVersion = 3;
+
+    //Appends the state of the machine, field by field in native byte order, to a buffer.
+    //The buffer keeps its capacity between snapshots, so taking one doesn't allocate.
+    class StateWriter
+    {
+        public:
+            StateWriter(std::vector<std::uint8_t>& buffer) : m_buffer(buffer) {}
+
+            template<typename T>
+            void write(const T& value)
+            {
+                static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be saved");
+                writeBytes(&value, sizeof(T));
+            }
+            //Memory whose size doesn't change while the ROM is loaded, so it isn't stored
+            void write(const std::vector<std::uint8_t>& memory) { writeBytes(memory.data(), memory.size()); }
+            void writeBytes(const void* data, std::size_t size)
+            {
+                auto bytes = static_cast<const std::uint8_t*>(data);
+                m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+            }
+            std::size_t size() { return m_buffer.size(); }
+            //Overwrites a value written before, e.g. a size that's only known at the end
+            template<typename T>
+            void patch(std::size_t offset, const T& value) { std::memcpy(&m_buffer[offset], &value, sizeof(T)); }
+        private:
+            std::vector<std::uint8_t>& m_buffer;
+    };
+
+    //Reads back what StateWriter wrote, in the same order. Reading past the end
+    //yields zeroes and makes good() false instead of overrunning the buffer.
+    class StateReader
+    {
+        public:
+            StateReader(const std::uint8_t* data, std::size_t size) : m_data(data), m_size(size), m_offset(0), m_good(true) {}
+
+            template<typename T>
+            void read(T& value)
+            {
+                static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be loaded");
+                readBytes(&value, sizeof(T));
+            }
+            template<typename T>
+            T read()
+            {
+                T value;
+                read(value);
+                return value;
+            }
+            void read(std::vector<std::uint8_t>& memory) { readBytes(memory.data(), memory.size()); }
+            void readBytes(void* data, std::size_t size)
+            {
+                if (size > m_size - m_offset)
+                {
+                    m_good = false;
+                    m_offset = m_size;
+                    std::memset(data, 0, size);
+                    return;
+                }
+                std::memcpy(data, m_data + m_offset, size);
+                m_offset += size;
+            }
+            //Marks the state as damaged, e.g. when a value in it is out of range
+            void fail() { m_good = false; }
+            bool good() { return m_good; }
+            bool atEnd() { return m_offset == m_size; }
+        private:
+            const std::uint8_t* m_data;
+            std::size_t m_size;
+            std::size_t m_offset;
+            bool m_good;
+    };
+}
+
+#endif // SAVESTATE_H
@@ -0,0 +1,43 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+#include <array>
+#include <cstdint>
+
+namespace sn
+{
+    //Master clock time, in PPU dots (three per CPU cycle) since power on
+    using Timestamp = std::uint64_t;
+
+    const Timestamp NeverScheduled = UINT64_MAX;
+
+    //Keeps the time of the next occurrence of every kind of event. There are only
+    //a handful of them, so a fixed slot per event is all the queue we need.
+    class Scheduler
+    {
+        public:
+            enum Event
+            {
+                VBlank,         //PPU sets the vblank flag and raises NMI
+                ScanlineIRQ,    //PPU clocks the mapper's scanline counter
+                FrameEnd,       //PPU hands a finished frame to the screen
+                PPUAccess,      //The CPU touched the PPU or the mapper, event times may have changed
+                TotalEvents,
+            };
+
+            Scheduler();
+            void schedule(Event event, Timestamp time);
+            void cancel(Event event);
+            void clear();
+
+            //Time of the earliest scheduled event
+            Timestamp nextEventTime() { return m_nextEventTime; }
+            Timestamp getEventTime(Event event) { return m_times[event]; }
+        private:
+            void updateNextEvent();
+
+            std::array<Timestamp, TotalEvents> m_times;
+            Timestamp m_nextEventTime;
+    };
+}
+
+#endif // SCHEDULER_H
@@ -0,0 +1,44 @@
+#ifndef SHAREDSTATE_H
+#define SHAREDSTATE_H
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace sn
+{
+    //A save state kept as pages that are shared with the state it was taken after, wherever they're
+    //equal. A frame or two apart, most of a state (CHR RAM, name tables, most of the RAM) is, so states
+    //forked from each other (e.g. the nodes of a search tree) take little more than the pages that differ.
+    //Copying one is forking it: the pages are never changed, only shared, so copies are one pointer copy
+    //and may be used from any thread.
+    class SharedState
+    {
+        public:
+            static const std::size_t PageSize = 256;
+
+            SharedState() = default;
+            //Splits the state into pages, sharing those of base (if any) that are equal
+            void assign(const std::vector<std::uint8_t>& state, const SharedState* base = nullptr);
+            //Joins the pages back into state
+            void copyTo(std::vector<std::uint8_t>& state) const;
+
+            bool empty() const { return !m_table; }
+            //Bytes of the state
+            std::size_t size() const { return m_table ? m_table->size : 0; }
+            //Memory taken by the pages not shared with base when it was assigned, and the page table
+            std::size_t getOwnMemory() const { return m_table ? m_table->ownMemory : 0; }
+        private:
+            using Page = std::array<std::uint8_t, PageSize>;
+            struct Table
+            {
+                std::vector<std::shared_ptr<const Page>> pages;
+                std::size_t size;
+                std::size_t ownMemory;
+            };
+
+            std::shared_ptr<const Table> m_table;
+    };
+}
+
+#endif // SHAREDSTATE_H
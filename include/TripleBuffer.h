@@ -0,0 +1,49 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+#include <atomic>
+
+namespace sn
+{
+    //Hands values from one thread to another without locks or waiting. The producer fills the back
+    //buffer and publishes it, the consumer takes the latest one published. Neither blocks the other,
+    //values published faster than they're taken are overwritten by the next one.
+    template <typename T>
+    class TripleBuffer
+    {
+        public:
+            TripleBuffer() :
+                m_back(0),
+                m_middle(1),
+                m_front(2)
+            {
+            }
+
+            //Producer side. The back buffer still has whatever it held when it was last taken.
+            T& getBack() { return m_buffers[m_back]; }
+            void publish()
+            {
+                m_back = m_middle.exchange(m_back | Fresh) & Index;
+            }
+
+            //Consumer side. True if a value was published since the last update, then it's the front one.
+            bool update()
+            {
+                if (!(m_middle.load() & Fresh))
+                    return false;
+                m_front = m_middle.exchange(m_front) & Index;
+                return true;
+            }
+            const T& getFront() const { return m_buffers[m_front]; }
+        private:
+            //The middle buffer's index, with Fresh set if it was published and hasn't been taken yet
+            static const int Index = 3;
+            static const int Fresh = 4;
+
+            T m_buffers[3];
+            int m_back;
+            std::atomic<int> m_middle;
+            int m_front;
+    };
+}
+
+#endif // TRIPLEBUFFER_H
@@ -0,0 +1,78 @@
+#ifndef VECTORENV_H
+#define VECTORENV_H
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Runner.h"
+
+namespace sn
+{
+    //Many instances of one game stepped in lockstep, for training agents. Every step each instance holds
+    //its action for a few frames, then its observation is written into buffers the caller owns, at the
+    //instance's offset. Nothing is allocated per step, and the instances are stepped on a Runner's threads.
+    class VectorEnv
+    {
+        public:
+            //Sizes of one instance's part of the observation buffers
+            static const std::size_t FrameSize = NESVideoWidth * NESVideoHeight;
+            static const std::size_t RAMSize = 0x800;
+
+            //Where to write the observations of all instances, any of them can be null if not wanted
+            struct Observations
+            {
+                //Last frame of each instance, FrameSize pixels as Console::getFrame() has them.
+                //Without it, nothing is drawn.
+                std::uint32_t* frames;
+                //Internal RAM of each instance, RAMSize bytes
+                Byte* ram;
+                //1 if the instance's episode is over, then its next step resets it instead
+                std::uint8_t* done;
+            };
+            //Whether the instance's episode is over, called after every step
+            using DoneCondition = std::function<bool(std::size_t instance, Console& console)>;
+
+            //0 threads starts one per core
+            explicit VectorEnv(unsigned threads = 0);
+            //Loads the ROM into the given number of instances, the state after loading is the one they're
+            //reset to until setResetState(). False if it couldn't be loaded.
+            bool create(const std::string& romPath, std::size_t instances);
+            std::size_t size() { return m_runner.getInstanceCount(); }
+            Console& getConsole(std::size_t instance) { return m_runner.getConsole(instance); }
+
+            //Every action is held for this many frames, of which only the last is drawn. Default: 1.
+            void setFrameSkip(int frames);
+            int getFrameSkip() { return m_frameSkip; }
+            void setDoneCondition(DoneCondition done) { m_doneCondition = done; }
+            //From now on, resets go to the current state and picture of the given instance (e.g. brought
+            //past the title screen)
+            void setResetState(std::size_t instance);
+
+            //Resets every instance and writes their observations. One that can't be reset is left as it was
+            //and marked done.
+            void reset(const Observations& out);
+            //Holds the buttons of controller 1 given for each instance (see Console::setButtons()) for the
+            //frame skip, or resets the ones that were done, then writes every observation
+            void step(const Byte* actions, const Observations& out);
+        private:
+            void resetInstance(std::size_t instance, Console& console);
+            void writeObservation(std::size_t instance, const std::vector<std::uint32_t>& frame,
+                                  const std::vector<Byte>& ram);
+
+            Runner m_runner;
+            int m_frameSkip;
+            DoneCondition m_doneCondition;
+
+            std::vector<Byte> m_resetState;
+            std::vector<std::uint32_t> m_resetFrame;
+            std::vector<std::uint8_t> m_done;
+
+            //Arguments of the step being run, read by the jobs
+            const Byte* m_actions;
+            Observations m_out;
+            Runner::Job m_resetJob, m_stepJob;
+    };
+}
+
+#endif // VECTORENV_H
@@ -1,21 +1,29 @@
 #ifndef VIRTUALSCREEN_H
 #define VIRTUALSCREEN_H
 #include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <vector>
 
 namespace sn
 {
+    //The picture as one texture, updated in a single upload per frame and drawn as one quad
+    //scaled up by the GPU
     class VirtualScreen : public sf::Drawable
     {
     public:
         void create (unsigned int width, unsigned int height, float pixel_size, sf::Color color);
-        void setPixel (std::size_t x, std::size_t y, sf::Color color);
+        //Replaces the whole picture with width x height RGBA pixels (0xRRGGBBAA) row by row
+        void setPixels (const std::uint32_t* pixels);
 
     private:
         void draw(sf::RenderTarget& target, sf::RenderStates states) const;
 
         sf::Vector2u m_screenSize;
         float m_pixelSize; //virtual pixel size in real pixels
-        sf::VertexArray m_vertices;
+        //The pixels in the byte order textures take them
+        std::vector<sf::Uint8> m_pixels;
+        sf::Texture m_texture;
+        sf::Sprite m_sprite;
     };
 };
 #endif // VIRTUALSCREEN_H
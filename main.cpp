@@ -1,4 +1,6 @@
 #include "Emulator.h"
+#include "Runner.h"
+#include "ROMIndex.h"
 #include "Log.h"
 #include <string>
 #include <sstream>
@@ -22,7 +24,9 @@ int main(int argc, char** argv)
 
     sn::Log::get().setLevel(sn::Info);
 
-    std::string path;
+    std::string path, frameDumpPath, ramDumpPath, moviePlayPath, indexDirectory, indexPath;
+    int headlessFrames = 0, benchmarkFrames = 0, runAhead = 0, instances = 1, threads = 0;
+    bool mapROM = false;
 
     //Default keybindings
     std::vector<sf::Keyboard::Key> p1 {sf::Keyboard::J, sf::Keyboard::K, sf::Keyboard::RShift, sf::Keyboard::Return,
@@ -39,7 +43,8 @@ int main(int argc, char** argv)
             std::cout << "SimpleNES is a simple NES emulator.\n"
                       << "It can run off .nes images.\n"
                       << "Set keybindings with keybindings.conf\n\n"
-                      << "Usage: SimpleNES [options] rom-path\n\n"
+                      << "Usage: SimpleNES [options] rom-path\n"
+                      << "       SimpleNES --index-roms directory index\n\n"
                       << "Options:\n"
                       << "-h, --help             Print this help text and exit\n"
                       << "-s, --scale            Set video scale. Default: 3.\n"
@@ -49,6 +54,29 @@ int main(int argc, char** argv)
                       << "-H, --height           Set the height of the emulation screen (width is\n"
                       << "                       set automatically to fit the aspect ratio)\n"
                       << "                       This option is mutually exclusive to --width\n"
+                      << "--rewind-memory <MB>   Memory kept for rewinding with backspace. Default: 8,\n"
+                      << "                       about a minute. 0 turns rewinding off\n"
+                      << "--rewind-keyframes <n> Keep every nth frame of the history whole. Default: 60.\n"
+                      << "                       Lower keeps less history in the same memory\n"
+                      << "--run-ahead <frames>   Show the frame this many frames ahead to hide that\n"
+                      << "                       much input lag. Default: 0. 1 or 2 suits most games\n"
+                      << "--record-movie <file>  Record the input from power on into a movie file,\n"
+                      << "                       saved on exit\n"
+                      << "--play-movie <file>    Replay a movie headless and as fast as possible, then\n"
+                      << "                       print the emulation speed. Takes --dump-frame/--dump-ram\n"
+                      << "--headless <frames>    Run for the given number of frames without a window\n"
+                      << "                       or keyboard, then exit\n"
+                      << "--dump-frame <file>    After a headless run, save the last frame as a PPM image\n"
+                      << "--dump-ram <file>      After a headless run, save the 2KB of internal RAM\n"
+                      << "--bench <frames>       Run the given number of frames headless and as fast as\n"
+                      << "                       possible, then print the emulation speed\n"
+                      << "--map-rom              Map the ROM file instead of reading it, for quicker\n"
+                      << "                       --headless, --bench and --play-movie runs\n"
+                      << "--index-roms <directory> <index>\n"
+                      << "                       Scan the .nes images under directory and write an index\n"
+                      << "                       of their headers and hashes. Takes --threads\n"
+                      << "--instances <n>        Benchmark this many instances of the ROM at once\n"
+                      << "--threads <n>          Threads to run the instances on. Default: one per core\n"
                       << std::endl;
             return 0;
         }
@@ -89,20 +117,167 @@ int main(int argc, char** argv)
                 LOG(sn::Error) << "Setting height from argument failed" << std::endl;
             ++i;
         }
+        else if (std::strcmp(argv[i], "--rewind-memory") == 0)
+        {
+            float megabytes;
+            std::stringstream ss;
+            if (i + 1 < argc && ss << argv[i + 1] && ss >> megabytes && megabytes >= 0)
+                emulator.setRewindMemory(megabytes * 1024 * 1024);
+            else
+                LOG(sn::Error) << "Setting rewind memory from argument failed" << std::endl;
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--rewind-keyframes") == 0)
+        {
+            int frames;
+            std::stringstream ss;
+            if (i + 1 < argc && ss << argv[i + 1] && ss >> frames && frames > 0)
+                emulator.setRewindKeyframeInterval(frames);
+            else
+                LOG(sn::Error) << "Setting rewind keyframe interval from argument failed" << std::endl;
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--run-ahead") == 0)
+        {
+            std::stringstream ss;
+            if (!(i + 1 < argc && ss << argv[i + 1] && ss >> runAhead) || runAhead < 0)
+            {
+                LOG(sn::Error) << "Setting run-ahead from argument failed" << std::endl;
+                runAhead = 0;
+            }
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--headless") == 0)
+        {
+            std::stringstream ss;
+            if (!(i + 1 < argc && ss << argv[i + 1] && ss >> headlessFrames) || headlessFrames <= 0)
+            {
+                LOG(sn::Error) << "Setting headless frame count from argument failed" << std::endl;
+                return 1;
+            }
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--bench") == 0)
+        {
+            std::stringstream ss;
+            if (!(i + 1 < argc && ss << argv[i + 1] && ss >> benchmarkFrames) || benchmarkFrames <= 0)
+            {
+                LOG(sn::Error) << "Setting benchmark frame count from argument failed" << std::endl;
+                return 1;
+            }
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--instances") == 0)
+        {
+            std::stringstream ss;
+            if (!(i + 1 < argc && ss << argv[i + 1] && ss >> instances) || instances <= 0)
+            {
+                LOG(sn::Error) << "Setting instance count from argument failed" << std::endl;
+                return 1;
+            }
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0)
+        {
+            std::stringstream ss;
+            if (!(i + 1 < argc && ss << argv[i + 1] && ss >> threads) || threads <= 0)
+            {
+                LOG(sn::Error) << "Setting thread count from argument failed" << std::endl;
+                return 1;
+            }
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--index-roms") == 0 && i + 2 < argc)
+        {
+            indexDirectory = argv[++i];
+            indexPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--map-rom") == 0)
+            mapROM = true;
+        else if (std::strcmp(argv[i], "--record-movie") == 0 && i + 1 < argc)
+            emulator.setMovieRecording(argv[++i]);
+        else if (std::strcmp(argv[i], "--play-movie") == 0 && i + 1 < argc)
+            moviePlayPath = argv[++i];
+        else if (std::strcmp(argv[i], "--dump-frame") == 0 && i + 1 < argc)
+            frameDumpPath = argv[++i];
+        else if (std::strcmp(argv[i], "--dump-ram") == 0 && i + 1 < argc)
+            ramDumpPath = argv[++i];
         else if (argv[i][0] != '-')
             path = argv[i];
         else
             std::cerr << "Unrecognized argument: " << argv[i] << std::endl;
     }
 
+    if (!indexDirectory.empty())
+        return sn::ROMIndex::build(indexDirectory, indexPath, threads, &std::cout) ? 0 : 1;
+
     if (path.empty())
     {
         std::cout << "Argument required: ROM path" << std::endl;
         return 1;
     }
 
+    if (benchmarkFrames > 0 && instances > 1)
+    {
+        //Only the first instance logs, the rest would repeat it
+        sn::Runner runner (threads);
+        for (int i = 0; i < instances; ++i)
+        {
+            if (!runner.addInstance(path, i == 0 ? &sn::Log::get().getStream() : nullptr, mapROM))
+                return 1;
+            runner.getConsole(i).setRunAhead(runAhead);
+        }
+        runner.benchmark(benchmarkFrames, std::cout);
+        return 0;
+    }
+
+    if (benchmarkFrames > 0)
+    {
+        sn::Console console;
+        if (!console.loadROM(path, mapROM))
+            return 1;
+
+        console.setRunAhead(runAhead);
+        console.benchmark(benchmarkFrames, std::cout);
+        return 0;
+    }
+
+    if (!moviePlayPath.empty())
+    {
+        sn::Console console;
+        sn::Movie movie;
+        if (!console.loadROM(path, mapROM) || !movie.loadFromFile(moviePlayPath) || !console.playMovie(movie))
+            return 1;
+
+        console.setRunAhead(runAhead);
+        console.benchmark(movie.getLength(), std::cout);
+
+        if (!frameDumpPath.empty() && !console.dumpFrame(frameDumpPath))
+            return 1;
+        if (!ramDumpPath.empty() && !console.dumpRAM(ramDumpPath))
+            return 1;
+        return 0;
+    }
+
+    if (headlessFrames > 0)
+    {
+        sn::Console console;
+        if (!console.loadROM(path, mapROM))
+            return 1;
+
+        auto frames = console.runFrames(headlessFrames);
+        LOG(sn::Info) << "Ran " << frames << " frames headless" << std::endl;
+
+        if (!frameDumpPath.empty() && !console.dumpFrame(frameDumpPath))
+            return 1;
+        if (!ramDumpPath.empty() && !console.dumpRAM(ramDumpPath))
+            return 1;
+        return 0;
+    }
+
     sn::parseControllerConf("keybindings.conf", p1, p2);
     emulator.setKeys(p1, p2);
+    emulator.setRunAhead(runAhead);
     emulator.run(path);
     return 0;
 }
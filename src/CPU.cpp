@@ -2,6 +2,7 @@
 #include "CPUOpcodes.h"
 #include "Log.h"
 #include <iomanip>
+#include <algorithm>
 
 namespace sn
 {
@@ -112,6 +113,19 @@ namespace sn
         m_skipCycles += (m_cycles & 1); //+1 if on odd cycle
     }
 
+    int CPU::executeInstruction()
+    {
+        ++m_cycles;
+        m_skipCycles = 0;
+        executeNext();
+
+        //The first cycle was counted above
+        auto cycles = m_skipCycles;
+        m_cycles += cycles - 1;
+        m_skipCycles = 0;
+        return cycles;
+    }
+
     void CPU::step()
     {
         ++m_cycles;
@@ -120,7 +134,11 @@ namespace sn
             return;
 
         m_skipCycles = 0;
+        executeNext();
+    }
 
+    void CPU::executeNext()
+    {
         // NMI has higher priority, check for it first
         if (m_pendingNMI)
         {
@@ -132,6 +150,8 @@ namespace sn
         {
             interruptSequence(IRQ);
             m_pendingNMI = m_pendingIRQ = false;
+            //A masked IRQ still uses up the cycle
+            m_skipCycles = std::max(m_skipCycles, 1);
             return;
         }
 
@@ -155,40 +175,277 @@ namespace sn
                   << "CYC:" << std::setw(3) << std::setfill(' ') << std::dec << ((m_cycles - 1) * 3) % 341
                   << std::endl;
 
-        Byte opcode = m_bus.read(r_PC++);
+        Byte op = m_bus.read(r_PC++);
+        auto opcode = OpcodeTable[op];
 
-        auto CycleLength = OperationCycles[opcode];
-
-        //Using short-circuit evaluation, call the other function only if the first failed
-        //ExecuteImplied must be called first and ExecuteBranch must be before ExecuteType0
-        if (CycleLength && (executeImplied(opcode) || executeBranch(opcode) ||
-                        executeType1(opcode) || executeType2(opcode) || executeType0(opcode)))
+        if (opcode.cycles)
         {
-            m_skipCycles += CycleLength;
-            //m_cycles %= 340; //compatibility with Nintendulator log
-            //m_skipCycles = 0; //for TESTING
+            execute(opcode, fetchOperand(opcode));
+            m_skipCycles += opcode.cycles;
         }
         else
         {
-            LOG(Error) << "Unrecognized opcode: " << std::hex << +opcode << std::endl;
+            LOG(Error) << "Unrecognized opcode: " << std::hex << +op << std::endl;
+            m_skipCycles = 1;
+        }
+    }
+
+    Address CPU::fetchOperand(Opcode opcode)
+    {
+        Address location = 0; //Location of the operand, could be in RAM
+        switch (opcode.mode)
+        {
+            case IMP:
+            case ACC:
+                break;
+            case IMM:
+            case REL:
+                location = r_PC++;
+                break;
+            case ZPG:
+                location = m_bus.read(r_PC++);
+                break;
+            case ZPX:
+                // Address wraps around in the zero page
+                location = (m_bus.read(r_PC++) + r_X) & 0xff;
+                break;
+            case ZPY:
+                location = (m_bus.read(r_PC++) + r_Y) & 0xff;
+                break;
+            case ABS:
+            case IND:
+                location = readAddress(r_PC);
+                r_PC += 2;
+                break;
+            case ABX:
+                location = readAddress(r_PC);
+                r_PC += 2;
+                if (opcode.pageCrossPenalty)
+                    setPageCrossed(location, location + r_X);
+                location += r_X;
+                break;
+            case ABY:
+                location = readAddress(r_PC);
+                r_PC += 2;
+                if (opcode.pageCrossPenalty)
+                    setPageCrossed(location, location + r_Y);
+                location += r_Y;
+                break;
+            case IZX:
+                {
+                    Byte zero_addr = r_X + m_bus.read(r_PC++);
+                    //Addresses wrap in zero page mode, thus pass through a mask
+                    location = m_bus.read(zero_addr & 0xff) | m_bus.read((zero_addr + 1) & 0xff) << 8;
+                }
+                break;
+            case IZY:
+                {
+                    Byte zero_addr = m_bus.read(r_PC++);
+                    location = m_bus.read(zero_addr & 0xff) | m_bus.read((zero_addr + 1) & 0xff) << 8;
+                    if (opcode.pageCrossPenalty)
+                        setPageCrossed(location, location + r_Y);
+                    location += r_Y;
+                }
+                break;
+        }
+        return location;
+    }
+
+    void CPU::branch(bool condition, Address location)
+    {
+        if (condition)
+        {
+            int8_t offset = m_bus.read(location);
+            ++m_skipCycles;
+            auto newPC = static_cast<Address>(r_PC + offset);
+            setPageCrossed(r_PC, newPC, 2);
+            r_PC = newPC;
         }
     }
 
-    bool CPU::executeImplied(Byte opcode)
+    void CPU::execute(Opcode opcode, Address location)
     {
-        switch (static_cast<OperationImplied>(opcode))
+        switch (opcode.operation)
         {
+            case ORA:
+                r_A |= m_bus.read(location);
+                setZN(r_A);
+                break;
+            case AND:
+                r_A &= m_bus.read(location);
+                setZN(r_A);
+                break;
+            case EOR:
+                r_A ^= m_bus.read(location);
+                setZN(r_A);
+                break;
+            case ADC:
+                {
+                    Byte operand = m_bus.read(location);
+                    std::uint16_t sum = r_A + operand + f_C;
+                    //Carry forward or UNSIGNED overflow
+                    f_C = sum & 0x100;
+                    //SIGNED overflow, would only happen if the sign of sum is
+                    //different from BOTH the operands
+                    f_V = (r_A ^ sum) & (operand ^ sum) & 0x80;
+                    r_A = static_cast<Byte>(sum);
+                    setZN(r_A);
+                }
+                break;
+            case SBC:
+                {
+                    //High carry means "no borrow", thus negate and subtract
+                    std::uint16_t subtrahend = m_bus.read(location),
+                             diff = r_A - subtrahend - !f_C;
+                    //if the ninth bit is 1, the resulting number is negative => borrow => low carry
+                    f_C = !(diff & 0x100);
+                    //Same as ADC, except instead of the subtrahend,
+                    //substitute with it's one complement
+                    f_V = (r_A ^ diff) & (~subtrahend ^ diff) & 0x80;
+                    r_A = diff;
+                    setZN(diff);
+                }
+                break;
+            case CMP:
+                {
+                    std::uint16_t diff = r_A - m_bus.read(location);
+                    f_C = !(diff & 0x100);
+                    setZN(diff);
+                }
+                break;
+            case CPX:
+                {
+                    std::uint16_t diff = r_X - m_bus.read(location);
+                    f_C = !(diff & 0x100);
+                    setZN(diff);
+                }
+                break;
+            case CPY:
+                {
+                    std::uint16_t diff = r_Y - m_bus.read(location);
+                    f_C = !(diff & 0x100);
+                    setZN(diff);
+                }
+                break;
+            case BIT:
+                {
+                    Byte operand = m_bus.read(location);
+                    f_Z = !(r_A & operand);
+                    f_V = operand & 0x40;
+                    f_N = operand & 0x80;
+                }
+                break;
+            case LDA:
+                r_A = m_bus.read(location);
+                setZN(r_A);
+                break;
+            case LDX:
+                r_X = m_bus.read(location);
+                setZN(r_X);
+                break;
+            case LDY:
+                r_Y = m_bus.read(location);
+                setZN(r_Y);
+                break;
+            case STA:
+                m_bus.write(location, r_A);
+                break;
+            case STX:
+                m_bus.write(location, r_X);
+                break;
+            case STY:
+                m_bus.write(location, r_Y);
+                break;
+            case ASL:
+            case ROL:
+                if (opcode.mode == ACC)
+                {
+                    auto prev_C = f_C;
+                    f_C = r_A & 0x80;
+                    r_A <<= 1;
+                    //If Rotating, set the bit-0 to the the previous carry
+                    r_A = r_A | (prev_C && (opcode.operation == ROL));
+                    setZN(r_A);
+                }
+                else
+                {
+                    auto prev_C = f_C;
+                    std::uint16_t operand = m_bus.read(location);
+                    f_C = operand & 0x80;
+                    operand = operand << 1 | (prev_C && (opcode.operation == ROL));
+                    setZN(operand);
+                    m_bus.write(location, operand);
+                }
+                break;
+            case LSR:
+            case ROR:
+                if (opcode.mode == ACC)
+                {
+                    auto prev_C = f_C;
+                    f_C = r_A & 1;
+                    r_A >>= 1;
+                    //If Rotating, set the bit-7 to the previous carry
+                    r_A = r_A | (prev_C && (opcode.operation == ROR)) << 7;
+                    setZN(r_A);
+                }
+                else
+                {
+                    auto prev_C = f_C;
+                    std::uint16_t operand = m_bus.read(location);
+                    f_C = operand & 1;
+                    operand = operand >> 1 | (prev_C && (opcode.operation == ROR)) << 7;
+                    setZN(operand);
+                    m_bus.write(location, operand);
+                }
+                break;
+            case DEC:
+                {
+                    auto tmp = m_bus.read(location) - 1;
+                    setZN(tmp);
+                    m_bus.write(location, tmp);
+                }
+                break;
+            case INC:
+                {
+                    auto tmp = m_bus.read(location) + 1;
+                    setZN(tmp);
+                    m_bus.write(location, tmp);
+                }
+                break;
+            case BPL:
+                branch(!f_N, location);
+                break;
+            case BMI:
+                branch(f_N, location);
+                break;
+            case BVC:
+                branch(!f_V, location);
+                break;
+            case BVS:
+                branch(f_V, location);
+                break;
+            case BCC:
+                branch(!f_C, location);
+                break;
+            case BCS:
+                branch(f_C, location);
+                break;
+            case BNE:
+                branch(!f_Z, location);
+                break;
+            case BEQ:
+                branch(f_Z, location);
+                break;
             case NOP:
                 break;
             case BRK:
                 interruptSequence(BRK_);
                 break;
             case JSR:
-                //Push address of next instruction - 1, thus r_PC + 1 instead of r_PC + 2
-                //since r_PC and r_PC + 1 are address of subroutine
-                pushStack(static_cast<Byte>((r_PC + 1) >> 8));
-                pushStack(static_cast<Byte>(r_PC + 1));
-                r_PC = readAddress(r_PC);
+                //Push address of next instruction - 1, r_PC already points past the operand
+                pushStack(static_cast<Byte>((r_PC - 1) >> 8));
+                pushStack(static_cast<Byte>(r_PC - 1));
+                r_PC = location;
                 break;
             case RTS:
                 r_PC = pullStack();
@@ -209,11 +466,8 @@ namespace sn
                 r_PC |= pullStack() << 8;
                 break;
             case JMP:
-                r_PC = readAddress(r_PC);
-                break;
-            case JMPI:
+                if (opcode.mode == IND)
                 {
-                    Address location = readAddress(r_PC);
                     //6502 has a bug such that the when the vector of anindirect address begins at the last byte of a page,
                     //the second byte is fetched from the beginning of that page rather than the beginning of the next
                     //Recreating here:
@@ -221,6 +475,8 @@ namespace sn
                     r_PC = m_bus.read(location) |
                            m_bus.read(Page | ((location + 1) & 0xff)) << 8;
                 }
+                else
+                    r_PC = location;
                 break;
             case PHP:
                 {
@@ -261,10 +517,6 @@ namespace sn
                 --r_X;
                 setZN(r_X);
                 break;
-            case TAY:
-                r_Y = r_A;
-                setZN(r_Y);
-                break;
             case INY:
                 ++r_Y;
                 setZN(r_Y);
@@ -273,6 +525,29 @@ namespace sn
                 ++r_X;
                 setZN(r_X);
                 break;
+            case TAY:
+                r_Y = r_A;
+                setZN(r_Y);
+                break;
+            case TYA:
+                r_A = r_Y;
+                setZN(r_A);
+                break;
+            case TAX:
+                r_X = r_A;
+                setZN(r_X);
+                break;
+            case TXA:
+                r_A = r_X;
+                setZN(r_A);
+                break;
+            case TSX:
+                r_X = r_SP;
+                setZN(r_X);
+                break;
+            case TXS:
+                r_SP = r_X;
+                break;
             case CLC:
                 f_C = false;
                 break;
@@ -291,393 +566,55 @@ namespace sn
             case SED:
                 f_D = true;
                 break;
-            case TYA:
-                r_A = r_Y;
-                setZN(r_A);
-                break;
             case CLV:
                 f_V = false;
                 break;
-            case TXA:
-                r_A = r_X;
-                setZN(r_A);
-                break;
-            case TXS:
-                r_SP = r_X;
-                break;
-            case TAX:
-                r_X = r_A;
-                setZN(r_X);
-                break;
-            case TSX:
-                r_X = r_SP;
-                setZN(r_X);
+            case XXX:
                 break;
-            default:
-                return false;
-        };
-        return true;
-    }
-
-    bool CPU::executeBranch(Byte opcode)
-    {
-        if ((opcode & BranchInstructionMask) == BranchInstructionMaskResult)
-        {
-            //branch is initialized to the condition required (for the flag specified later)
-            bool branch = opcode & BranchConditionMask;
-
-            //set branch to true if the given condition is met by the given flag
-            //We use xnor here, it is true if either both operands are true or false
-            switch (opcode >> BranchOnFlagShift)
-            {
-                case Negative:
-                    branch = !(branch ^ f_N);
-                    break;
-                case Overflow:
-                    branch = !(branch ^ f_V);
-                    break;
-                case Carry:
-                    branch = !(branch ^ f_C);
-                    break;
-                case Zero:
-                    branch = !(branch ^ f_Z);
-                    break;
-                default:
-                    return false;
-            }
-
-            if (branch)
-            {
-                int8_t offset = m_bus.read(r_PC++);
-                ++m_skipCycles;
-                auto newPC = static_cast<Address>(r_PC + offset);
-                setPageCrossed(r_PC, newPC, 2);
-                r_PC = newPC;
-            }
-            else
-                ++r_PC;
-            return true;
         }
-        return false;
     }
 
-    bool CPU::executeType1(Byte opcode)
-    {
-        if ((opcode & InstructionModeMask) == 0x1)
-        {
-            Address location = 0; //Location of the operand, could be in RAM
-            auto op = static_cast<Operation1>((opcode & OperationMask) >> OperationShift);
-            switch (static_cast<AddrMode1>(
-                    (opcode & AddrModeMask) >> AddrModeShift))
-            {
-                case IndexedIndirectX:
-                    {
-                        Byte zero_addr = r_X + m_bus.read(r_PC++);
-                        //Addresses wrap in zero page mode, thus pass through a mask
-                        location = m_bus.read(zero_addr & 0xff) | m_bus.read((zero_addr + 1) & 0xff) << 8;
-                    }
-                    break;
-                case ZeroPage:
-                    location = m_bus.read(r_PC++);
-                    break;
-                case Immediate:
-                    location = r_PC++;
-                    break;
-                case Absolute:
-                    location = readAddress(r_PC);
-                    r_PC += 2;
-                    break;
-                case IndirectY:
-                    {
-                        Byte zero_addr = m_bus.read(r_PC++);
-                        location = m_bus.read(zero_addr & 0xff) | m_bus.read((zero_addr + 1) & 0xff) << 8;
-                        if (op != STA)
-                            setPageCrossed(location, location + r_Y);
-                        location += r_Y;
-                    }
-                    break;
-                case IndexedX:
-                    // Address wraps around in the zero page
-                    location = (m_bus.read(r_PC++) + r_X) & 0xff;
-                    break;
-                case AbsoluteY:
-                    location = readAddress(r_PC);
-                    r_PC += 2;
-                    if (op != STA)
-                        setPageCrossed(location, location + r_Y);
-                    location += r_Y;
-                    break;
-                case AbsoluteX:
-                    location = readAddress(r_PC);
-                    r_PC += 2;
-                    if (op != STA)
-                        setPageCrossed(location, location + r_X);
-                    location += r_X;
-                    break;
-                default:
-                    return false;
-            }
-
-            switch (op)
-            {
-                case ORA:
-                    r_A |= m_bus.read(location);
-                    setZN(r_A);
-                    break;
-                case AND:
-                    r_A &= m_bus.read(location);
-                    setZN(r_A);
-                    break;
-                case EOR:
-                    r_A ^= m_bus.read(location);
-                    setZN(r_A);
-                    break;
-                case ADC:
-                    {
-                        Byte operand = m_bus.read(location);
-                        std::uint16_t sum = r_A + operand + f_C;
-                        //Carry forward or UNSIGNED overflow
-                        f_C = sum & 0x100;
-                        //SIGNED overflow, would only happen if the sign of sum is
-                        //different from BOTH the operands
-                        f_V = (r_A ^ sum) & (operand ^ sum) & 0x80;
-                        r_A = static_cast<Byte>(sum);
-                        setZN(r_A);
-                    }
-                    break;
-                case STA:
-                    m_bus.write(location, r_A);
-                    break;
-                case LDA:
-                    r_A = m_bus.read(location);
-                    setZN(r_A);
-                    break;
-                case SBC:
-                    {
-                        //High carry means "no borrow", thus negate and subtract
-                        std::uint16_t subtrahend = m_bus.read(location),
-                                 diff = r_A - subtrahend - !f_C;
-                        //if the ninth bit is 1, the resulting number is negative => borrow => low carry
-                        f_C = !(diff & 0x100);
-                        //Same as ADC, except instead of the subtrahend,
-                        //substitute with it's one complement
-                        f_V = (r_A ^ diff) & (~subtrahend ^ diff) & 0x80;
-                        r_A = diff;
-                        setZN(diff);
-                    }
-                    break;
-                case CMP:
-                    {
-                        std::uint16_t diff = r_A - m_bus.read(location);
-                        f_C = !(diff & 0x100);
-                        setZN(diff);
-                    }
-                    break;
-                default:
-                    return false;
-            }
-            return true;
-        }
-        return false;
-    }
-
-    bool CPU::executeType2(Byte opcode)
+    Address CPU::readAddress(Address addr)
     {
-        if ((opcode & InstructionModeMask) == 2)
-        {
-            Address location = 0;
-            auto op = static_cast<Operation2>((opcode & OperationMask) >> OperationShift);
-            auto addr_mode =
-                    static_cast<AddrMode2>((opcode & AddrModeMask) >> AddrModeShift);
-            switch (addr_mode)
-            {
-                case Immediate_:
-                    location = r_PC++;
-                    break;
-                case ZeroPage_:
-                    location = m_bus.read(r_PC++);
-                    break;
-                case Accumulator:
-                    break;
-                case Absolute_:
-                    location = readAddress(r_PC);
-                    r_PC += 2;
-                    break;
-                case Indexed:
-                    {
-                        location = m_bus.read(r_PC++);
-                        Byte index;
-                        if (op == LDX || op == STX)
-                            index = r_Y;
-                        else
-                            index = r_X;
-                        //The mask wraps address around zero page
-                        location = (location + index) & 0xff;
-                    }
-                    break;
-                case AbsoluteIndexed:
-                    {
-                        location = readAddress(r_PC);
-                        r_PC += 2;
-                        Byte index;
-                        if (op == LDX || op == STX)
-                            index = r_Y;
-                        else
-                            index = r_X;
-                        setPageCrossed(location, location + index);
-                        location += index;
-                    }
-                    break;
-                default:
-                    return false;
-            }
-
-            std::uint16_t operand = 0;
-            switch (op)
-            {
-                case ASL:
-                case ROL:
-                    if (addr_mode == Accumulator)
-                    {
-                        auto prev_C = f_C;
-                        f_C = r_A & 0x80;
-                        r_A <<= 1;
-                        //If Rotating, set the bit-0 to the the previous carry
-                        r_A = r_A | (prev_C && (op == ROL));
-                        setZN(r_A);
-                    }
-                    else
-                    {
-                        auto prev_C = f_C;
-                        operand = m_bus.read(location);
-                        f_C = operand & 0x80;
-                        operand = operand << 1 | (prev_C && (op == ROL));
-                        setZN(operand);
-                        m_bus.write(location, operand);
-                    }
-                    break;
-                case LSR:
-                case ROR:
-                    if (addr_mode == Accumulator)
-                    {
-                        auto prev_C = f_C;
-                        f_C = r_A & 1;
-                        r_A >>= 1;
-                        //If Rotating, set the bit-7 to the previous carry
-                        r_A = r_A | (prev_C && (op == ROR)) << 7;
-                        setZN(r_A);
-                    }
-                    else
-                    {
-                        auto prev_C = f_C;
-                        operand = m_bus.read(location);
-                        f_C = operand & 1;
-                        operand = operand >> 1 | (prev_C && (op == ROR)) << 7;
-                        setZN(operand);
-                        m_bus.write(location, operand);
-                    }
-                    break;
-                case STX:
-                    m_bus.write(location, r_X);
-                    break;
-                case LDX:
-                    r_X = m_bus.read(location);
-                    setZN(r_X);
-                    break;
-                case DEC:
-                    {
-                        auto tmp = m_bus.read(location) - 1;
-                        setZN(tmp);
-                        m_bus.write(location, tmp);
-                    }
-                    break;
-                case INC:
-                    {
-                        auto tmp = m_bus.read(location) + 1;
-                        setZN(tmp);
-                        m_bus.write(location, tmp);
-                    }
-                    break;
-                default:
-                    return false;
-            }
-            return true;
-        }
-        return false;
+        return m_bus.read(addr) | m_bus.read(addr + 1) << 8;
     }
 
-    bool CPU::executeType0(Byte opcode)
+    void CPU::saveState(StateWriter& state)
     {
-        if ((opcode & InstructionModeMask) == 0x0)
-        {
-            Address location = 0;
-            switch (static_cast<AddrMode2>((opcode & AddrModeMask) >> AddrModeShift))
-            {
-                case Immediate_:
-                    location = r_PC++;
-                    break;
-                case ZeroPage_:
-                    location = m_bus.read(r_PC++);
-                    break;
-                case Absolute_:
-                    location = readAddress(r_PC);
-                    r_PC += 2;
-                    break;
-                case Indexed:
-                    // Address wraps around in the zero page
-                    location = (m_bus.read(r_PC++) + r_X) & 0xff;
-                    break;
-                case AbsoluteIndexed:
-                    location = readAddress(r_PC);
-                    r_PC += 2;
-                    setPageCrossed(location, location + r_X);
-                    location += r_X;
-                    break;
-                default:
-                    return false;
-            }
-            std::uint16_t operand = 0;
-            switch (static_cast<Operation0>((opcode & OperationMask) >> OperationShift))
-            {
-                case BIT:
-                    operand = m_bus.read(location);
-                    f_Z = !(r_A & operand);
-                    f_V = operand & 0x40;
-                    f_N = operand & 0x80;
-                    break;
-                case STY:
-                    m_bus.write(location, r_Y);
-                    break;
-                case LDY:
-                    r_Y = m_bus.read(location);
-                    setZN(r_Y);
-                    break;
-                case CPY:
-                    {
-                        std::uint16_t diff = r_Y - m_bus.read(location);
-                        f_C = !(diff & 0x100);
-                        setZN(diff);
-                    }
-                    break;
-                case CPX:
-                    {
-                        std::uint16_t diff = r_X - m_bus.read(location);
-                        f_C = !(diff & 0x100);
-                        setZN(diff);
-                    }
-                    break;
-                default:
-                    return false;
-            }
-
-            return true;
-        }
-        return false;
+        state.write(m_skipCycles);
+        state.write(m_cycles);
+        state.write(r_PC);
+        state.write(r_SP);
+        state.write(r_A);
+        state.write(r_X);
+        state.write(r_Y);
+        state.write(f_C);
+        state.write(f_Z);
+        state.write(f_I);
+        state.write(f_D);
+        state.write(f_V);
+        state.write(f_N);
+        state.write(m_pendingNMI);
+        state.write(m_pendingIRQ);
     }
 
-    Address CPU::readAddress(Address addr)
+    void CPU::loadState(StateReader& state)
     {
-        return m_bus.read(addr) | m_bus.read(addr + 1) << 8;
+        state.read(m_skipCycles);
+        state.read(m_cycles);
+        state.read(r_PC);
+        state.read(r_SP);
+        state.read(r_A);
+        state.read(r_X);
+        state.read(r_Y);
+        state.read(f_C);
+        state.read(f_Z);
+        state.read(f_I);
+        state.read(f_D);
+        state.read(f_V);
+        state.read(f_N);
+        state.read(m_pendingNMI);
+        state.read(m_pendingIRQ);
     }
 
 };
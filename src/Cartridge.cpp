@@ -2,25 +2,31 @@
 #include "Log.h"
 #include "Mapper.h"
 #include <fstream>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 namespace sn
 {
     Cartridge::Cartridge() :
+        m_image(std::make_shared<Image>()),
         m_nameTableMirroring(0),
         m_mapperNumber(0),
-        m_extendedRAM(false)
+        m_extendedRAM(false),
+        m_hashed(false),
+        m_hash(0)
     {
 
     }
-    const std::vector<Byte>& Cartridge::getROM()
+
+    const ROMView& Cartridge::getROM()
     {
-        return m_PRG_ROM;
+        return m_image->PRG_ROM;
     }
 
-    const std::vector<Byte>& Cartridge::getVROM()
+    const ROMView& Cartridge::getVROM()
     {
-        return m_CHR_ROM;
+        return m_image->CHR_ROM;
     }
 
     Byte Cartridge::getMapper()
@@ -39,98 +45,210 @@ namespace sn
         return true;
     }
 
-    bool Cartridge::loadFromFile(std::string path)
+    std::uint64_t Cartridge::getHash()
     {
-        std::ifstream romFile (path, std::ios_base::binary | std::ios_base::in);
-        if (!romFile)
+        if (!m_hashed)
         {
-            LOG(Error) << "Could not open ROM file from path: " << path << std::endl;
-            return false;
+            m_hash = hash(m_image->PRG_ROM, m_image->CHR_ROM, m_mapperNumber);
+            m_hashed = true;
         }
+        return m_hash;
+    }
 
-        std::vector<Byte> header;
-        LOG(Info) << "Reading ROM from path: " << path << std::endl;
+    std::uint64_t Cartridge::hash(const ROMView& prg, const ROMView& chr, std::uint16_t mapper)
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+        auto add = [&](Byte b) { hash = (hash ^ b) * 1099511628211ull; };
+        for (std::size_t i = 0; i < prg.size(); ++i)
+            add(prg[i]);
+        for (std::size_t i = 0; i < chr.size(); ++i)
+            add(chr[i]);
+        //Only NES 2.0 mappers go past a byte
+        add(mapper & 0xff);
+        if (mapper > 0xff)
+            add(mapper >> 8);
+        return hash;
+    }
 
-        //Header
-        header.resize(0x10);
-        if (!romFile.read(reinterpret_cast<char*>(&header[0]), 0x10))
+    bool Cartridge::parseHeader(const Byte* image, std::size_t size, ROMHeader& header)
+    {
+        if (size < 0x10)
         {
             LOG(Error) << "Reading iNES header failed." << std::endl;
             return false;
         }
-        if (std::string{&header[0], &header[4]} != "NES\x1A")
+        if (std::string{&image[0], &image[4]} != "NES\x1A")
         {
             LOG(Error) << "Not a valid iNES image. Magic number: "
-                      << std::hex << header[0] << " "
-                      << header[1] << " " << header[2] << " " << int(header[3]) << std::endl
+                      << std::hex << image[0] << " "
+                      << image[1] << " " << image[2] << " " << int(image[3]) << std::endl
                       << "Valid magic number : N E S 1a" << std::endl;
             return false;
         }
 
-        LOG(Info) << "Reading header, it dictates: \n";
-
-        Byte banks = header[4];
-        LOG(Info) << "16KB PRG-ROM Banks: " << +banks << std::endl;
-        if (!banks)
+        header.nes2 = (image[7] & 0xc) == 0x8;
+        header.mapper = ((image[6] >> 4) & 0xf) | (image[7] & 0xf0);
+        header.prgBanks = image[4];
+        header.chrBanks = image[5];
+        if (header.nes2)
         {
-            LOG(Error) << "ROM has no PRG-ROM banks. Loading ROM failed." << std::endl;
-            return false;
+            header.mapper |= (image[8] & 0xf) << 8;
+            header.prgBanks |= (image[9] & 0xf) << 8;
+            header.chrBanks |= (image[9] >> 4) << 8;
         }
 
-        Byte vbanks = header[5];
-        LOG(Info) << "8KB CHR-ROM Banks: " << +vbanks << std::endl;
+        header.nameTableMirroring = image[6] & 0x8 ? NameTableMirroring::FourScreen : image[6] & 0x1;
+        header.extendedRAM = image[6] & 0x2;
+        header.trainer = image[6] & 0x4;
 
-        if (header[6] & 0x8)
-        {
-            m_nameTableMirroring = NameTableMirroring::FourScreen;
-            LOG(Info) << "Name Table Mirroring: " << "FourScreen" << std::endl;
-        }
+        if (header.nes2)
+            header.region = static_cast<ROMHeader::Region>(image[12] & 0x3);
         else
         {
-            m_nameTableMirroring = header[6] & 0x1;
-            LOG(Info) << "Name Table Mirroring: " << (m_nameTableMirroring == 0 ? "Horizontal" : "Vertical") << std::endl;
+            //Unofficial, but the only place iNES has it
+            switch (image[0xA] & 0x3)
+            {
+                case 0: header.region = ROMHeader::NTSC; break;
+                case 2: header.region = ROMHeader::PAL; break;
+                default: header.region = ROMHeader::MultiRegion; break;
+            }
         }
+        return true;
+    }
 
-        m_mapperNumber = ((header[6] >> 4) & 0xf) | (header[7] & 0xf0);
-        LOG(Info) << "Mapper #: " << +m_mapperNumber << std::endl;
-
-        m_extendedRAM = header[6] & 0x2;
-        LOG(Info) << "Extended (CPU) RAM: " << std::boolalpha << m_extendedRAM << std::endl;
-
-        if (header[6] & 0x4)
+    bool Cartridge::isSupported(const ROMHeader& header, std::size_t size)
+    {
+        if (!header.prgBanks)
+        {
+            LOG(Error) << "ROM has no PRG-ROM banks. Loading ROM failed." << std::endl;
+            return false;
+        }
+        if (header.trainer)
         {
             LOG(Error) << "Trainer is not supported." << std::endl;
             return false;
         }
-
-        if ((header[0xA] & 0x3) == 0x2 || (header[0xA] & 0x1))
+        if (header.region == ROMHeader::PAL || header.region == ROMHeader::Dendy)
         {
             LOG(Error) << "PAL ROM not supported." << std::endl;
             return false;
         }
-        else
-            LOG(Info) << "ROM is NTSC compatible.\n";
+        if (header.mapper > 0xff || !Mapper::isSupported(static_cast<Mapper::Type>(header.mapper)))
+        {
+            LOG(Error) << "Mapper #" << header.mapper << " is not supported." << std::endl;
+            return false;
+        }
 
-        //PRG-ROM 16KB banks
-        m_PRG_ROM.resize(0x4000 * banks);
-        if (!romFile.read(reinterpret_cast<char*>(&m_PRG_ROM[0]), 0x4000 * banks))
+        //Exponent-multiplier sizes (a nibble of 0xf) are way beyond anything supported
+        std::size_t prgSize = 0x4000 * header.prgBanks, chrSize = 0x2000 * header.chrBanks;
+        if (size < 0x10 + prgSize)
         {
             LOG(Error) << "Reading PRG-ROM from image file failed." << std::endl;
             return false;
         }
+        if (size < 0x10 + prgSize + chrSize)
+        {
+            LOG(Error) << "Reading CHR-ROM from image file failed." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool Cartridge::readFile(const std::string& path, bool mapFile, Image& image)
+    {
+        if (mapFile)
+        {
+            if (image.mapping.open(path))
+                return true;
+            LOG(Info) << "Could not map " << path << ", reading it instead" << std::endl;
+        }
+
+        std::ifstream romFile (path, std::ios_base::binary | std::ios_base::in | std::ios_base::ate);
+        if (!romFile)
+        {
+            LOG(Error) << "Could not open ROM file from path: " << path << std::endl;
+            return false;
+        }
+        image.buffer.resize(romFile.tellg());
+        romFile.seekg(0);
+        return static_cast<bool>(romFile.read(reinterpret_cast<char*>(image.buffer.data()), image.buffer.size()));
+    }
 
-        //CHR-ROM 8KB banks
-        if (vbanks)
+    std::shared_ptr<const Cartridge::Image> Cartridge::shareImage(std::shared_ptr<const Image> image, std::uint64_t hash)
+    {
+        //Only holds on to the images while cartridges use them
+        static std::mutex mutex;
+        static std::unordered_map<std::uint64_t, std::weak_ptr<const Image>> images;
+
+        std::lock_guard<std::mutex> lock (mutex);
+        auto& shared = images[hash];
+        auto existing = shared.lock();
+        if (existing && existing->PRG_ROM == image->PRG_ROM && existing->CHR_ROM == image->CHR_ROM)
         {
-            m_CHR_ROM.resize(0x2000 * vbanks);
-            if (!romFile.read(reinterpret_cast<char*>(&m_CHR_ROM[0]), 0x2000 * vbanks))
-            {
-                LOG(Error) << "Reading CHR-ROM from image file failed." << std::endl;
-                return false;
-            }
+            LOG(InfoVerbose) << "ROM already loaded, sharing it" << std::endl;
+            return existing;
+        }
+
+        shared = image;
+        for (auto it = images.begin(); it != images.end();)
+        {
+            if (it->second.expired())
+                it = images.erase(it);
+            else
+                ++it;
+        }
+        return image;
+    }
+
+    bool Cartridge::loadFromFile(std::string path, bool mapFile)
+    {
+        LOG(Info) << "Reading ROM from path: " << path << std::endl;
+        auto image = std::make_shared<Image>();
+        if (!readFile(path, mapFile, *image))
+            return false;
+        auto file = image->mapping.isOpen() ? image->mapping.data() : image->buffer.data();
+        auto fileSize = image->mapping.isOpen() ? image->mapping.size() : image->buffer.size();
+
+        ROMHeader header;
+        if (!Cartridge::parseHeader(file, fileSize, header))
+            return false;
+
+        LOG(Info) << "Reading header, it dictates: \n";
+        LOG(Info) << "Format: " << (header.nes2 ? "NES 2.0" : "iNES") << std::endl;
+        LOG(Info) << "16KB PRG-ROM Banks: " << header.prgBanks << std::endl;
+        LOG(Info) << "8KB CHR-ROM Banks: " << header.chrBanks << std::endl;
+        if (header.nameTableMirroring == NameTableMirroring::FourScreen)
+        {
+            LOG(Info) << "Name Table Mirroring: " << "FourScreen" << std::endl;
         }
+        else
+        {
+            LOG(Info) << "Name Table Mirroring: " << (header.nameTableMirroring == 0 ? "Horizontal" : "Vertical") << std::endl;
+        }
+        LOG(Info) << "Mapper #: " << header.mapper << std::endl;
+        LOG(Info) << "Extended (CPU) RAM: " << std::boolalpha << header.extendedRAM << std::endl;
+
+        if (!isSupported(header, fileSize))
+            return false;
+        LOG(Info) << "ROM is NTSC compatible.\n";
+
+        m_nameTableMirroring = header.nameTableMirroring;
+        m_mapperNumber = header.mapper;
+        m_extendedRAM = header.extendedRAM;
+
+        //PRG-ROM 16KB banks right after the header, then CHR-ROM 8KB banks
+        std::size_t prgSize = 0x4000 * header.prgBanks, chrSize = 0x2000 * header.chrBanks;
+        image->PRG_ROM = ROMView(file + 0x10, prgSize);
+        if (chrSize)
+            image->CHR_ROM = ROMView(file + 0x10 + prgSize, chrSize);
         else
             LOG(Info) << "Cartridge with CHR-RAM." << std::endl;
+
+        m_image = image;
+        m_hashed = false;
+        //A mapped file is already shared through the page cache
+        if (!image->mapping.isOpen())
+            m_image = shareImage(image, getHash());
         return true;
     }
 }
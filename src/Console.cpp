@@ -0,0 +1,489 @@
+#include "Console.h"
+#include "CPUOpcodes.h"
+#include "Log.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+
+namespace sn
+{
+    Console::Console() :
+        m_cpu(m_bus),
+        m_ppu(m_pictureBus),
+        m_ppuClock(0),
+        m_lastFrame(0),
+        m_speculating(false),
+        m_rewindEnabled(false),
+        m_videoEnabled(true),
+        m_runAhead(0),
+        m_movieMode(NoMovie),
+        m_movie(nullptr),
+        m_movieStart(0),
+        m_frameStart(0),
+        m_buttons()
+    {
+        m_bus.setPPU(&m_ppu);
+        m_bus.setControllers(&m_controller1, &m_controller2);
+        m_bus.setProfiler(&m_profiler);
+        if (!m_bus.setWriteCallback(OAMDMA, [&](Byte b) {DMA(b);}))
+        {
+            LOG(Error) << "Critical error: Failed to set I/O callbacks" << std::endl;
+        }
+
+        m_ppu.setInterruptCallback([&](){ m_cpu.interrupt(InterruptType::NMI); });
+
+        //Called in the middle of an instruction, the PPU has to be where it was at the instruction's first cycle
+        m_bus.setSyncCallback([&](){
+            syncPPU(m_cpu.getCycles() * 3);
+            m_scheduler.schedule(Scheduler::PPUAccess, m_ppuClock);
+        });
+    }
+
+    bool Console::loadROM(std::string rom_path, bool mapFile)
+    {
+        stopMovie();
+        if (!m_cartridge.loadFromFile(rom_path, mapFile))
+            return false;
+
+        m_mapper = Mapper::createMapper(static_cast<Mapper::Type>(m_cartridge.getMapper()),
+                                        m_cartridge,
+                                        [&](){ m_cpu.interrupt(InterruptType::IRQ); },
+                                        [&](){ m_pictureBus.updateMirroring(); });
+        if (!m_mapper)
+        {
+            LOG(Error) << "Creating Mapper failed. Probably unsupported." << std::endl;
+            return false;
+        }
+
+        if (!m_bus.setMapper(m_mapper.get()) ||
+            !m_pictureBus.setMapper(m_mapper.get()))
+            return false;
+
+        m_cpu.reset();
+        m_ppu.reset();
+        //The PPU stays one CPU cycle ahead, exactly as when both were stepped every cycle
+        m_ppuClock = 0;
+        syncPPU(clock());
+        m_scheduler.clear();
+        schedulePPUEvents();
+
+        m_rewindBuffer.clear();
+        m_lastFrame = m_ppu.getFrameCount();
+        return true;
+    }
+
+    std::uint64_t Console::runCycles(std::uint64_t cycles)
+    {
+        auto start = m_cpu.getCycles();
+        runUntil(clock() + cycles * 3);
+        return m_cpu.getCycles() - start;
+    }
+
+    void Console::runFrame()
+    {
+        //The frame end may be predicted a dot early, keep going until it really is over
+        auto frame = m_ppu.getFrameCount();
+        while (m_ppu.getFrameCount() == frame)
+            runUntil(m_scheduler.getEventTime(Scheduler::FrameEnd));
+    }
+
+    int Console::runFrames(int frames, std::function<bool(void)> stop)
+    {
+        int frame = 0;
+        while (frame < frames)
+        {
+            runFrame();
+            ++frame;
+            if (stop && stop())
+                break;
+        }
+        return frame;
+    }
+
+    void Console::benchmark(int frames, std::ostream& out)
+    {
+        auto startCycles = m_cpu.getCycles();
+        auto startDots = m_ppuClock;
+
+        m_profiler.reset();
+        m_profiler.setEnabled(true);
+        auto start = Profiler::Clock::now();
+        frames = runFrames(frames);
+        std::chrono::duration<double> elapsed = Profiler::Clock::now() - start;
+        m_profiler.setEnabled(false);
+
+        auto seconds = elapsed.count();
+        auto cycles = m_cpu.getCycles() - startCycles;
+        auto dots = m_ppuClock - startDots;
+        std::chrono::duration<double> ppu = m_profiler.getTime(Profiler::PPU),
+                                      mapper = m_profiler.getTime(Profiler::Mapper);
+        std::chrono::duration<double> emulated = cycles * CPUCycleDuration;
+        auto cpu = seconds - ppu.count() - mapper.count();
+
+        out << std::fixed << std::setprecision(3)
+            << "Frames:     " << frames << " in " << seconds << " s, " << frames / seconds << " frames/s\n"
+            << "CPU cycles: " << cycles << ", " << cycles / seconds / 1e6 << " M/s\n"
+            << "PPU dots:   " << dots << ", " << dots / seconds / 1e6 << " M/s\n"
+            << "Speed:      " << emulated.count() / seconds << "x real NES\n"
+            << "Time in CPU (and bus): " << cpu << " s, " << 100 * cpu / seconds << "%\n"
+            << "Time in PPU:           " << ppu.count() << " s, " << 100 * ppu.count() / seconds << "%\n"
+            << "Time in mapper writes: " << mapper.count() << " s, " << 100 * mapper.count() / seconds << "%\n";
+    }
+
+    void Console::setButtons(int controller, Byte buttons)
+    {
+        m_buttons[controller != 0] = buttons;
+        if (m_movieMode == PlayingMovie)
+            return;
+        if (m_movieMode == RecordingMovie)
+        {
+            if (clock() != m_frameStart)
+                return;
+            m_movie->setInput(m_ppu.getFrameCount() - m_movieStart, m_buttons);
+        }
+        (controller == 0 ? m_controller1 : m_controller2).setButtons(buttons);
+    }
+
+    void Console::recordMovie(Movie& movie)
+    {
+        stopMovie();
+        m_movie = &movie;
+        m_movieMode = RecordingMovie;
+        m_movieStart = m_ppu.getFrameCount();
+        m_frameStart = clock();
+
+        std::vector<Byte> state;
+        saveState(state);
+        movie.setROMHash(m_cartridge.getHash());
+        movie.setStartState(state);
+        m_buttons = {{m_controller1.getButtons(), m_controller2.getButtons()}};
+        movie.setInput(0, m_buttons);
+    }
+
+    bool Console::playMovie(Movie& movie)
+    {
+        stopMovie();
+        if (movie.getROMHash() != m_cartridge.getHash())
+        {
+            LOG(Error) << "The movie is for another ROM" << std::endl;
+            return false;
+        }
+        if (!loadState(movie.getStartState()))
+            return false;
+
+        m_movie = &movie;
+        m_movieMode = PlayingMovie;
+        m_movieStart = m_ppu.getFrameCount();
+        updateMovie();
+        return true;
+    }
+
+    void Console::stopMovie()
+    {
+        //Only the frames completed are kept, playing it back ends where recording did
+        if (m_movieMode == RecordingMovie)
+            m_movie->truncate(m_ppu.getFrameCount() - m_movieStart);
+        m_movieMode = NoMovie;
+        m_movie = nullptr;
+    }
+
+    void Console::updateMovie()
+    {
+        m_frameStart = clock();
+        if (m_ppu.getFrameCount() < m_movieStart)
+        {
+            LOG(Info) << "Went back before the start of the movie, stopped it" << std::endl;
+            stopMovie();
+            return;
+        }
+
+        auto frame = m_ppu.getFrameCount() - m_movieStart;
+        if (m_movieMode == RecordingMovie)
+            m_movie->setInput(frame, m_buttons);
+        else if (frame < m_movie->getLength())
+            m_buttons = m_movie->getInput(frame);
+        else
+        {
+            LOG(Info) << "Movie finished after " << frame << " frames" << std::endl;
+            stopMovie();
+            return;
+        }
+        m_controller1.setButtons(m_buttons[0]);
+        m_controller2.setButtons(m_buttons[1]);
+    }
+
+    void Console::saveState(std::vector<Byte>& buffer)
+    {
+        buffer.clear();
+        if (!m_mapper)
+        {
+            LOG(Error) << "No ROM loaded to save the state of" << std::endl;
+            return;
+        }
+
+        StateWriter state (buffer);
+        state.write(SaveStateMagic);
+        state.write(SaveStateVersion);
+        state.write(std::uint32_t(0)); //Size, known at the end
+        state.write(m_cartridge.getHash());
+
+        //The mapper goes before the buses, they point their pages to its banks when loaded
+        m_cpu.saveState(state);
+        m_mapper->saveState(state);
+        m_bus.saveState(state);
+        m_pictureBus.saveState(state);
+        m_ppu.saveState(state);
+        m_controller1.saveState(state);
+        m_controller2.saveState(state);
+        state.write(m_ppuClock);
+
+        state.patch(2 * sizeof(std::uint32_t), static_cast<std::uint32_t>(state.size()));
+    }
+
+    bool Console::loadState(const Byte* data, std::size_t size)
+    {
+        if (!m_mapper)
+        {
+            LOG(Error) << "No ROM loaded to restore the state of" << std::endl;
+            return false;
+        }
+
+        //Only the header can be checked before anything is touched, the rest while it's loaded. So the
+        //machine is saved first and put back as it was if the load fails.
+        StateReader state (data, size);
+        if (!readStateHeader(state, size))
+            return false;
+        saveState(m_loadBackup);
+        if (!readState(state))
+        {
+            LOG(Error) << "Damaged save state" << std::endl;
+            StateReader backup (m_loadBackup.data(), m_loadBackup.size());
+            readStateHeader(backup, m_loadBackup.size());
+            readState(backup);
+            return false;
+        }
+
+        m_scheduler.clear();
+        schedulePPUEvents();
+        m_lastFrame = m_ppu.getFrameCount();
+        return true;
+    }
+
+    bool Console::readStateHeader(StateReader& state, std::size_t size)
+    {
+        if (state.read<std::uint32_t>() != SaveStateMagic ||
+            state.read<std::uint32_t>() != SaveStateVersion ||
+            state.read<std::uint32_t>() != size)
+        {
+            LOG(Error) << "Not a save state of this version" << std::endl;
+            return false;
+        }
+        if (state.read<std::uint64_t>() != m_cartridge.getHash())
+        {
+            LOG(Error) << "The save state is of another ROM" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool Console::readState(StateReader& state)
+    {
+        m_cpu.loadState(state);
+        m_mapper->loadState(state);
+        m_bus.loadState(state);
+        m_pictureBus.loadState(state);
+        m_ppu.loadState(state);
+        m_controller1.loadState(state);
+        m_controller2.loadState(state);
+        state.read(m_ppuClock);
+        return state.good() && state.atEnd();
+    }
+
+    void Console::saveState(SharedState& state, const SharedState* base)
+    {
+        saveState(m_sharedStateBuffer);
+        state.assign(m_sharedStateBuffer, base);
+    }
+
+    bool Console::loadState(const SharedState& state)
+    {
+        state.copyTo(m_sharedStateBuffer);
+        return loadState(m_sharedStateBuffer);
+    }
+
+    void Console::setRewindEnabled(bool enabled)
+    {
+        m_rewindEnabled = enabled;
+        if (!enabled)
+            m_rewindBuffer.clear();
+    }
+
+    bool Console::rewindFrame()
+    {
+        //The newest snapshot is the end of the last frame. The pictures aren't kept, so the
+        //frame before it is run again from the snapshot before that to draw it. It's only dropped
+        //once both are loaded, if either can't be the console goes back to where it was.
+        if (m_rewindBuffer.size() < 3 || !m_rewindBuffer.get(2, m_rewindState) || !loadState(m_rewindState))
+            return false;
+
+        m_speculating = true;
+        m_ppu.setOutputEnabled(m_videoEnabled);
+        runFrame();
+        m_ppu.setOutputEnabled(m_videoEnabled && m_runAhead == 0);
+        m_speculating = false;
+
+        //Input may have changed mid-frame, land exactly on the recorded state
+        if (!m_rewindBuffer.get(1, m_rewindState) || !loadState(m_rewindState))
+        {
+            LOG(Error) << "Could not rewind, the history is damaged" << std::endl;
+            m_rewindBuffer.get(0, m_rewindState);
+            loadState(m_rewindState);
+            return false;
+        }
+        m_rewindBuffer.drop(1);
+        return true;
+    }
+
+    void Console::setRunAhead(int frames)
+    {
+        m_runAhead = frames > 0 ? frames : 0;
+        //The frames really run are never shown while running ahead
+        m_ppu.setOutputEnabled(m_videoEnabled && m_runAhead == 0);
+    }
+
+    void Console::setVideoEnabled(bool enabled)
+    {
+        m_videoEnabled = enabled;
+        m_ppu.setOutputEnabled(m_videoEnabled && m_runAhead == 0);
+    }
+
+    void Console::checkFrameEnd()
+    {
+        //Frames end on a scheduled event, so this is the first instruction after the end
+        if (m_ppu.getFrameCount() == m_lastFrame || m_speculating)
+            return;
+        m_lastFrame = m_ppu.getFrameCount();
+
+        if (m_movieMode != NoMovie)
+            updateMovie();
+        if (m_rewindEnabled)
+        {
+            saveState(m_rewindState);
+            m_rewindBuffer.push(m_rewindState);
+        }
+        //Running ahead only changes the picture
+        if (m_runAhead > 0 && m_videoEnabled)
+            runAhead();
+    }
+
+    void Console::runAhead()
+    {
+        saveState(m_runAheadState);
+        m_speculating = true;
+        for (int frame = 1; frame <= m_runAhead; ++frame)
+        {
+            m_ppu.setOutputEnabled(frame == m_runAhead);
+            runFrame();
+        }
+        m_ppu.setOutputEnabled(false);
+        m_speculating = false;
+
+        //The pictures aren't part of the state, the last one drawn stays until the next run-ahead
+        if (!loadState(m_runAheadState))
+        {
+            //The machine is ahead then, running ahead again would only take it further
+            LOG(Error) << "Could not go back after running ahead, running ahead is turned off" << std::endl;
+            setRunAhead(0);
+        }
+    }
+
+    bool Console::dumpFrame(const std::string& path)
+    {
+        std::ofstream file (path, std::ios::binary);
+        if (!file)
+        {
+            LOG(Error) << "Could not open " << path << " to dump the frame" << std::endl;
+            return false;
+        }
+
+        //Binary PPM, simple enough to not need an image library
+        file << "P6\n" << NESVideoWidth << " " << NESVideoHeight << "\n255\n";
+        for (auto color : m_ppu.getFrame())
+        {
+            file.put(color >> 24).put(color >> 16).put(color >> 8);
+        }
+        return file.good();
+    }
+
+    bool Console::dumpRAM(const std::string& path)
+    {
+        std::ofstream file (path, std::ios::binary);
+        if (!file)
+        {
+            LOG(Error) << "Could not open " << path << " to dump the RAM" << std::endl;
+            return false;
+        }
+
+        auto& ram = m_bus.getRAM();
+        file.write(reinterpret_cast<const char*>(ram.data()), ram.size());
+        return file.good();
+    }
+
+    void Console::runUntil(Timestamp time)
+    {
+        for (auto now = clock(); ; now = clock())
+        {
+            //Events are never scheduled late, so an interrupt the PPU raises is
+            //pending before the first instruction that would have seen it
+            if (now >= m_scheduler.nextEventTime())
+            {
+                syncPPU(now);
+                schedulePPUEvents();
+                checkFrameEnd();
+            }
+
+            if (now >= time)
+                break;
+
+            m_cpu.executeInstruction();
+        }
+    }
+
+    void Console::syncPPU(Timestamp time)
+    {
+        if (time > m_ppuClock)
+        {
+            Profiler::Scope scope (&m_profiler, Profiler::PPU);
+            m_ppu.run(time - m_ppuClock);
+            m_ppuClock = time;
+        }
+    }
+
+    void Console::schedulePPUEvents()
+    {
+        m_scheduler.cancel(Scheduler::PPUAccess);
+        m_scheduler.schedule(Scheduler::VBlank, m_ppuClock + m_ppu.dotsUntilVBlank());
+        m_scheduler.schedule(Scheduler::FrameEnd, m_ppuClock + m_ppu.dotsUntilFrameEnd());
+
+        auto irq = m_ppu.dotsUntilScanlineIRQ();
+        if (irq > 0 && m_mapper->scanlineIRQEnabled())
+            m_scheduler.schedule(Scheduler::ScanlineIRQ, m_ppuClock + irq);
+        else
+            m_scheduler.cancel(Scheduler::ScanlineIRQ);
+    }
+
+    void Console::DMA(Byte page)
+    {
+        m_cpu.skipDMACycles();
+        auto page_ptr = m_bus.getPagePtr(page);
+        if (page_ptr != nullptr)
+        {
+            m_ppu.doDMA(page_ptr);
+        }
+        else
+        {
+            LOG(Error) << "Can't get pageptr for DMA" << std::endl;
+        }
+    }
+}
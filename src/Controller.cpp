@@ -3,22 +3,15 @@
 namespace sn
 {
     Controller::Controller() :
+        m_strobe(false),
         m_keyStates(0),
-        m_keyBindings(TotalButtons)
+        m_buttons(0)
     {
-//         m_keyBindings[A] = sf::Keyboard::J;
-//         m_keyBindings[B] = sf::Keyboard::K;
-//         m_keyBindings[Select] = sf::Keyboard::RShift;
-//         m_keyBindings[Start] = sf::Keyboard::Return;
-//         m_keyBindings[Up] = sf::Keyboard::W;
-//         m_keyBindings[Down] = sf::Keyboard::S;
-//         m_keyBindings[Left] = sf::Keyboard::A;
-//         m_keyBindings[Right] = sf::Keyboard::D;
     }
 
-    void Controller::setKeyBindings(const std::vector<sf::Keyboard::Key>& keys)
+    void Controller::setButtons(Byte buttons)
     {
-        m_keyBindings = keys;
+        m_buttons = buttons;
     }
 
     void Controller::strobe(Byte b)
@@ -26,13 +19,7 @@ namespace sn
         m_strobe = (b & 1);
         if (!m_strobe)
         {
-            m_keyStates = 0;
-            int shift = 0;
-            for (int button = A; button < TotalButtons; ++button)
-            {
-                m_keyStates |= (sf::Keyboard::isKeyPressed(m_keyBindings[static_cast<Buttons>(button)]) << shift);
-                ++shift;
-            }
+            m_keyStates = m_buttons;
         }
     }
 
@@ -40,7 +27,7 @@ namespace sn
     {
         Byte ret;
         if (m_strobe)
-            ret = sf::Keyboard::isKeyPressed(m_keyBindings[A]);
+            ret = (m_buttons & 1);
         else
         {
             ret = (m_keyStates & 1);
@@ -49,4 +36,18 @@ namespace sn
         return ret | 0x40;
     }
 
-}
\ No newline at end of file
+    void Controller::saveState(StateWriter& state)
+    {
+        state.write(m_strobe);
+        state.write(m_keyStates);
+        state.write(m_buttons);
+    }
+
+    void Controller::loadState(StateReader& state)
+    {
+        state.read(m_strobe);
+        state.read(m_keyStates);
+        state.read(m_buttons);
+    }
+
+}
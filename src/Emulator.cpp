@@ -1,5 +1,4 @@
 #include "Emulator.h"
-#include "CPUOpcodes.h"
 #include "Log.h"
 
 #include <thread>
@@ -8,67 +7,35 @@
 namespace sn
 {
     Emulator::Emulator() :
-        m_cpu(m_bus),
-        m_ppu(m_pictureBus, m_emulatorScreen),
         m_screenScale(3.f),
+        m_shownFrame(0),
         m_cycleTimer(),
-        m_cpuCycleDuration(std::chrono::nanoseconds(559))
+        m_cpuCycleDuration(CPUCycleDuration),
+        m_running(false),
+        m_paused(false),
+        m_focused(true),
+        m_rewinding(false),
+        m_fastForward(false),
+        m_framesToStep(0)
     {
-        if(!m_bus.setReadCallback(PPUSTATUS, [&](void) {return m_ppu.getStatus();}) ||
-            !m_bus.setReadCallback(PPUDATA, [&](void) {return m_ppu.getData();}) ||
-            !m_bus.setReadCallback(JOY1, [&](void) {return m_controller1.read();}) ||
-            !m_bus.setReadCallback(JOY2, [&](void) {return m_controller2.read();}) ||
-            !m_bus.setReadCallback(OAMDATA, [&](void) {return m_ppu.getOAMData();}))
-        {
-            LOG(Error) << "Critical error: Failed to set I/O callbacks" << std::endl;
-        }
-
-
-        if(!m_bus.setWriteCallback(PPUCTRL, [&](Byte b) {m_ppu.control(b);}) ||
-            !m_bus.setWriteCallback(PPUMASK, [&](Byte b) {m_ppu.setMask(b);}) ||
-            !m_bus.setWriteCallback(OAMADDR, [&](Byte b) {m_ppu.setOAMAddress(b);}) ||
-            !m_bus.setWriteCallback(PPUADDR, [&](Byte b) {m_ppu.setDataAddress(b);}) ||
-            !m_bus.setWriteCallback(PPUSCROL, [&](Byte b) {m_ppu.setScroll(b);}) ||
-            !m_bus.setWriteCallback(PPUDATA, [&](Byte b) {m_ppu.setData(b);}) ||
-            !m_bus.setWriteCallback(OAMDMA, [&](Byte b) {DMA(b);}) ||
-            !m_bus.setWriteCallback(JOY1, [&](Byte b) {m_controller1.strobe(b); m_controller2.strobe(b);}) ||
-            !m_bus.setWriteCallback(OAMDATA, [&](Byte b) {m_ppu.setOAMData(b);}))
-        {
-            LOG(Error) << "Critical error: Failed to set I/O callbacks" << std::endl;
-        }
-
-        m_ppu.setInterruptCallback([&](){ m_cpu.interrupt(InterruptType::NMI); });
+        m_buttons[0] = m_buttons[1] = 0;
     }
 
     void Emulator::run(std::string rom_path)
     {
-        if (!m_cartridge.loadFromFile(rom_path))
+        if (!m_console.loadROM(rom_path))
             return;
-
-        m_mapper = Mapper::createMapper(static_cast<Mapper::Type>(m_cartridge.getMapper()),
-                                        m_cartridge,
-                                        [&](){ m_cpu.interrupt(InterruptType::IRQ); },
-                                        [&](){ m_pictureBus.updateMirroring(); });
-        if (!m_mapper)
-        {
-            LOG(Error) << "Creating Mapper failed. Probably unsupported." << std::endl;
-            return;
-        }
-
-        if (!m_bus.setMapper(m_mapper.get()) ||
-            !m_pictureBus.setMapper(m_mapper.get()))
-            return;
-
-        m_cpu.reset();
-        m_ppu.reset();
+        m_console.setRewindEnabled(m_console.getRewindBuffer().getMemoryLimit() > 0);
+        if (!m_moviePath.empty())
+            m_console.recordMovie(m_movie);
 
         m_window.create(sf::VideoMode(NESVideoWidth * m_screenScale, NESVideoHeight * m_screenScale),
                         "SimpleNES", sf::Style::Titlebar | sf::Style::Close | sf::Style::Resize);
         m_window.setVerticalSyncEnabled(true);
         m_emulatorScreen.create(NESVideoWidth, NESVideoHeight, m_screenScale, sf::Color::White);
 
-        m_cycleTimer = std::chrono::high_resolution_clock::now();
-        m_elapsedTime = m_cycleTimer - m_cycleTimer;
+        m_running = true;
+        m_emulation = std::thread(&Emulator::emulate, this);
 
         sf::Event event;
         bool focus = true, pause = false;
@@ -80,39 +47,19 @@ namespace sn
                 (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape))
                 {
                     m_window.close();
-                    return;
+                    break;
                 }
                 else if (event.type == sf::Event::GainedFocus)
-                {
                     focus = true;
-                    m_cycleTimer = std::chrono::high_resolution_clock::now();
-                }
                 else if (event.type == sf::Event::LostFocus)
                     focus = false;
                 else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F2)
                 {
                     pause = !pause;
-                    if (!pause)
-                    {
-                        m_cycleTimer = std::chrono::high_resolution_clock::now();
-                        LOG(Info) << "Paused." << std::endl;
-                    }
-                    else
-                    {
-                        LOG(Info) << "Unpaused." << std::endl;
-                    }
                 }
                 else if (pause && event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::F3)
                 {
-                    for (int i = 0; i < 29781; ++i) //Around one frame
-                    {
-                        //PPU
-                        m_ppu.step();
-                        m_ppu.step();
-                        m_ppu.step();
-                        //CPU
-                        m_cpu.step();
-                    }
+                    ++m_framesToStep;
                 }
                 else if (focus && event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::F4)
                 {
@@ -123,47 +70,149 @@ namespace sn
                     Log::get().setLevel(InfoVerbose);
                 }
             }
+            if (!m_window.isOpen())
+                break;
 
-            if (focus && !pause)
-            {
-                m_elapsedTime += std::chrono::high_resolution_clock::now() - m_cycleTimer;
-                m_cycleTimer = std::chrono::high_resolution_clock::now();
+            m_paused = pause;
+            m_focused = focus;
+            m_rewinding = focus && sf::Keyboard::isKeyPressed(sf::Keyboard::BackSpace);
+            m_fastForward = focus && sf::Keyboard::isKeyPressed(sf::Keyboard::Tab);
+            m_buttons[0] = readKeys(m_p1Keys);
+            m_buttons[1] = readKeys(m_p2Keys);
 
-                while (m_elapsedTime > m_cpuCycleDuration)
-                {
-                    //PPU
-                    m_ppu.step();
-                    m_ppu.step();
-                    m_ppu.step();
-                    //CPU
-                    m_cpu.step();
-
-                    m_elapsedTime -= m_cpuCycleDuration;
-                }
+            bool newFrame = m_frames.update();
+            if (newFrame)
+                m_emulatorScreen.setPixels(m_frames.getFront().data());
 
+            if ((focus && !pause) || newFrame)
+            {
                 m_window.draw(m_emulatorScreen);
                 m_window.display();
             }
             else
             {
                 sf::sleep(sf::milliseconds(1000/60));
-                //std::this_thread::sleep_for(std::chrono::milliseconds(1000/60)); //1/60 second
+            }
+        }
+
+        //The Console is only touched from this thread once the emulation is over
+        m_running = false;
+        m_emulation.join();
+        if (m_console.isRecordingMovie())
+        {
+            m_console.stopMovie();
+            if (m_movie.saveToFile(m_moviePath))
+            {
+                LOG(Info) << "Saved movie of " << m_movie.getLength() << " frames to " << m_moviePath << std::endl;
             }
         }
     }
 
-    void Emulator::DMA(Byte page)
+    void Emulator::emulate()
     {
-        m_cpu.skipDMACycles();
-        auto page_ptr = m_bus.getPagePtr(page);
-        if (page_ptr != nullptr)
+        using Clock = std::chrono::high_resolution_clock;
+        //Frames are 341 * 262 dots, 3 per CPU cycle (a dot less every other one)
+        const auto frameDuration = ScanlineCycleLength * (FrameEndScanline + 1) / 3 * m_cpuCycleDuration;
+        //When the thread fell further behind than this, the time lost is dropped instead of caught up in a burst
+        const auto maxLag = 4 * frameDuration;
+
+        m_cycleTimer = Clock::now();
+        m_elapsedTime = m_cycleTimer - m_cycleTimer;
+        auto lastShown = m_cycleTimer;
+        bool paused = false;
+        while (m_running)
         {
-            m_ppu.doDMA(page_ptr);
+            auto now = Clock::now();
+            if (m_paused != paused)
+            {
+                paused = !paused;
+                if (paused)
+                {
+                    LOG(Info) << "Paused." << std::endl;
+                }
+                else
+                {
+                    LOG(Info) << "Unpaused." << std::endl;
+                }
+            }
+            if (paused || !m_focused)
+            {
+                if (m_framesToStep > 0)
+                {
+                    --m_framesToStep;
+                    m_console.runFrame();
+                    publishFrame();
+                }
+                else
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                m_cycleTimer = now;
+                continue;
+            }
+
+            m_elapsedTime += now - m_cycleTimer;
+            m_cycleTimer = now;
+            if (m_elapsedTime > maxLag)
+                m_elapsedTime = maxLag;
+
+            if (m_rewinding)
+            {
+                //Goes back a frame for every frame that would have been run, instead of running
+                while (m_elapsedTime >= frameDuration)
+                {
+                    m_console.rewindFrame();
+                    m_elapsedTime -= frameDuration;
+                }
+            }
+            else
+            {
+                m_console.setButtons(0, m_buttons[0]);
+                m_console.setButtons(1, m_buttons[1]);
+                if (m_fastForward)
+                {
+                    //As fast as it goes. Only about as many frames as the window shows are drawn, the
+                    //others are run without output and not handed over.
+                    bool shown = now - lastShown >= frameDuration;
+                    m_console.setVideoEnabled(shown);
+                    m_console.runFrame();
+                    m_console.setVideoEnabled(true);
+                    if (shown)
+                        lastShown = now;
+                    else
+                        m_shownFrame = m_console.getFrameCount();
+                    m_elapsedTime = m_elapsedTime.zero();
+                }
+                else
+                {
+                    auto cycles = m_console.runCycles(m_elapsedTime / m_cpuCycleDuration);
+                    m_elapsedTime -= static_cast<int>(cycles) * m_cpuCycleDuration;
+                }
+            }
+            publishFrame();
+
+            //Each frame is handed over within about a millisecond of when it's due
+            if (!m_fastForward)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
         }
-        else
+    }
+
+    Byte Emulator::readKeys(const std::vector<sf::Keyboard::Key>& keys)
+    {
+        Byte buttons = 0;
+        for (std::size_t button = 0; button < keys.size() && button < Controller::TotalButtons; ++button)
         {
-            LOG(Error) << "Can't get pageptr for DMA" << std::endl;
+            buttons |= sf::Keyboard::isKeyPressed(keys[button]) << button;
         }
+        return buttons;
+    }
+
+    void Emulator::publishFrame()
+    {
+        if (m_console.getFrameCount() == m_shownFrame)
+            return;
+        m_shownFrame = m_console.getFrameCount();
+
+        m_frames.getBack() = m_console.getFrame();
+        m_frames.publish();
     }
 
     void Emulator::setVideoHeight(int height)
@@ -187,10 +236,30 @@ namespace sn
                   << int(NESVideoWidth * m_screenScale) << "x" << int(NESVideoHeight * m_screenScale) << std::endl;
     }
 
+    void Emulator::setRewindMemory(std::size_t bytes)
+    {
+        m_console.getRewindBuffer().setMemoryLimit(bytes);
+    }
+
+    void Emulator::setRewindKeyframeInterval(int frames)
+    {
+        m_console.getRewindBuffer().setKeyframeInterval(frames);
+    }
+
+    void Emulator::setRunAhead(int frames)
+    {
+        m_console.setRunAhead(frames);
+    }
+
+    void Emulator::setMovieRecording(const std::string& path)
+    {
+        m_moviePath = path;
+    }
+
     void Emulator::setKeys(std::vector<sf::Keyboard::Key>& p1, std::vector<sf::Keyboard::Key>& p2)
     {
-        m_controller1.setKeyBindings(p1);
-        m_controller2.setKeyBindings(p2);
+        m_p1Keys = p1;
+        m_p2Keys = p2;
     }
 
 }
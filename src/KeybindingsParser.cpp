@@ -3,6 +3,7 @@
 #include <fstream>
 #include <algorithm>
 #include <cctype>
+#include <SFML/Window.hpp>
 
 #include "Controller.h"
 #include "Log.h"
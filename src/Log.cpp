@@ -2,6 +2,18 @@
 
 namespace sn
 {
+    namespace
+    {
+        thread_local Log* currentLog = nullptr;
+    }
+
+    Log::Log() :
+        m_logLevel(None),
+        m_logStream(nullptr),
+        m_cpuTrace(nullptr)
+    {
+    }
+
     Log::~Log()
     {
     }
@@ -9,7 +21,14 @@ namespace sn
     Log& Log::get()
     {
         static Log instance;
-        return instance;
+        return currentLog ? *currentLog : instance;
+    }
+
+    Log* Log::setCurrent(Log* log)
+    {
+        auto previous = currentLog;
+        currentLog = log;
+        return previous;
     }
 
     std::ostream& Log::getCpuTraceStream()
@@ -1,4 +1,6 @@
 #include "MainBus.h"
+#include "PPU.h"
+#include "Controller.h"
 #include <cstring>
 #include "Log.h"
 
@@ -6,19 +8,42 @@ namespace sn
 {
     MainBus::MainBus() :
         m_RAM(0x800, 0),
-        m_mapper(nullptr)
+        m_mapper(nullptr),
+        m_ppu(nullptr),
+        m_controller1(nullptr),
+        m_controller2(nullptr),
+        m_profiler(nullptr)
     {
+        m_readPages.fill(nullptr);
+        m_writePages.fill(nullptr);
+
+        //2KB of RAM mirrored up to 0x2000
+        for (int page = 0; page < 0x20; ++page)
+            m_readPages[page] = m_writePages[page] = &m_RAM[(page << 8) & 0x7ff];
     }
 
-    Byte MainBus::read(Address addr)
+    Byte MainBus::readIO(Address addr)
     {
-        if (addr < 0x2000)
-            return m_RAM[addr & 0x7ff];
-        else if (addr < 0x4020)
+        if (addr < 0x4020)
         {
             if (addr < 0x4000) //PPU registers, mirrored
             {
-                auto it = m_readCallbacks.find(static_cast<IORegisters>(addr & 0x2007));
+                if (m_syncCallback)
+                    m_syncCallback();
+
+                auto reg = static_cast<IORegisters>(addr & 0x2007);
+                if (m_ppu)
+                {
+                    switch (reg)
+                    {
+                        case PPUSTATUS: return m_ppu->getStatus();
+                        case PPUDATA:   return m_ppu->getData();
+                        case OAMDATA:   return m_ppu->getOAMData();
+                        default: break;
+                    }
+                }
+
+                auto it = m_readCallbacks.find(reg);
                 if (it != m_readCallbacks.end())
                     return (it -> second)();
                     //Second object is the pointer to the function object
@@ -28,6 +53,11 @@ namespace sn
             }
             else if (addr < 0x4018 && addr >= 0x4014) //Only *some* IO registers
             {
+                if (addr == JOY1 && m_controller1)
+                    return m_controller1->read();
+                else if (addr == JOY2 && m_controller2)
+                    return m_controller2->read();
+
                 auto it = m_readCallbacks.find(static_cast<IORegisters>(addr));
                 if (it != m_readCallbacks.end())
                     return (it -> second)();
@@ -57,15 +87,35 @@ namespace sn
         return 0;
     }
 
-    void MainBus::write(Address addr, Byte value)
+    void MainBus::writeIO(Address addr, Byte value)
     {
-        if (addr < 0x2000)
-            m_RAM[addr & 0x7ff] = value;
-        else if (addr < 0x4020)
+        if (addr < 0x4020)
         {
+            if (addr < 0x4000 || addr == OAMDMA) //PPU registers (mirrored) and OAM DMA
+            {
+                if (m_syncCallback)
+                    m_syncCallback();
+            }
+
             if (addr < 0x4000) //PPU registers, mirrored
             {
-                auto it = m_writeCallbacks.find(static_cast<IORegisters>(addr & 0x2007));
+                auto reg = static_cast<IORegisters>(addr & 0x2007);
+                if (m_ppu)
+                {
+                    switch (reg)
+                    {
+                        case PPUCTRL:   m_ppu->control(value); return;
+                        case PPUMASK:   m_ppu->setMask(value); return;
+                        case OAMADDR:   m_ppu->setOAMAddress(value); return;
+                        case OAMDATA:   m_ppu->setOAMData(value); return;
+                        case PPUSCROL:  m_ppu->setScroll(value); return;
+                        case PPUADDR:   m_ppu->setDataAddress(value); return;
+                        case PPUDATA:   m_ppu->setData(value); return;
+                        default: break;
+                    }
+                }
+
+                auto it = m_writeCallbacks.find(reg);
                 if (it != m_writeCallbacks.end())
                     (it -> second)(value);
                     //Second object is the pointer to the function object
@@ -75,6 +125,14 @@ namespace sn
             }
             else if (addr < 0x4017 && addr >= 0x4014) //only some registers
             {
+                if (addr == JOY1 && m_controller1)
+                {
+                    m_controller1->strobe(value);
+                    if (m_controller2)
+                        m_controller2->strobe(value);
+                    return;
+                }
+
                 auto it = m_writeCallbacks.find(static_cast<IORegisters>(addr));
                 if (it != m_writeCallbacks.end())
                     (it -> second)(value);
@@ -99,10 +157,37 @@ namespace sn
         }
         else
         {
+            if (m_syncCallback)
+                m_syncCallback();
+
+            Profiler::Scope scope (m_profiler, Profiler::Mapper);
             m_mapper->writePRG(addr, value);
+            //Might have switched banks
+            mapPRG();
         }
     }
 
+    void MainBus::setPPU(PPU* ppu)
+    {
+        m_ppu = ppu;
+    }
+
+    void MainBus::setControllers(Controller* controller1, Controller* controller2)
+    {
+        m_controller1 = controller1;
+        m_controller2 = controller2;
+    }
+
+    void MainBus::setProfiler(Profiler* profiler)
+    {
+        m_profiler = profiler;
+    }
+
+    void MainBus::setSyncCallback(std::function<void(void)> callback)
+    {
+        m_syncCallback = callback;
+    }
+
     const Byte* MainBus::getPagePtr(Byte page)
     {
         Address addr = page << 8;
@@ -143,11 +228,32 @@ namespace sn
         }
 
         if (mapper->hasExtendedRAM())
+        {
             m_extRAM.resize(0x2000);
+            for (int page = 0x60; page < 0x80; ++page)
+                m_readPages[page] = m_writePages[page] = &m_extRAM[(page - 0x60) << 8];
+        }
+        else
+        {
+            //Left from a previous cartridge otherwise, they go through readIO/writeIO like the rest
+            //of the unmapped space
+            for (int page = 0x60; page < 0x80; ++page)
+                m_readPages[page] = m_writePages[page] = nullptr;
+        }
 
+        mapPRG();
         return true;
     }
 
+    void MainBus::mapPRG()
+    {
+        for (int page = 0x80; page < 0x100; ++page)
+        {
+            auto bank = m_mapper->getPRGPage(page << 8);
+            m_readPages[page] = bank ? bank + ((page << 8) & 0x1fff) : nullptr;
+        }
+    }
+
     bool MainBus::setWriteCallback(IORegisters reg, std::function<void(Byte)> callback)
     {
         if (!callback)
@@ -168,4 +274,17 @@ namespace sn
         return m_readCallbacks.emplace(reg, callback).second;
     }
 
+    void MainBus::saveState(StateWriter& state)
+    {
+        state.write(m_RAM);
+        state.write(m_extRAM);
+    }
+
+    void MainBus::loadState(StateReader& state)
+    {
+        state.read(m_RAM);
+        state.read(m_extRAM);
+        mapPRG();
+    }
+
 };
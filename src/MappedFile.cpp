@@ -0,0 +1,57 @@
+#include "MappedFile.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SN_MAP_FILES
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sn
+{
+    MappedFile::MappedFile() :
+        m_data(nullptr),
+        m_size(0)
+    {}
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    bool MappedFile::open(const std::string& path)
+    {
+        close();
+#ifdef SN_MAP_FILES
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            auto data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                m_data = data;
+                m_size = info.st_size;
+            }
+        }
+        ::close(fd);
+#else
+        (void)path;
+#endif
+        return isOpen();
+    }
+
+    void MappedFile::close()
+    {
+#ifdef SN_MAP_FILES
+        if (m_data)
+            munmap(m_data, m_size);
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
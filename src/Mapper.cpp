@@ -11,11 +11,97 @@
 
 namespace sn
 {
+    Byte Mapper::readPRG(Address addr)
+    {
+        return m_prgPages[(addr >> 13) & 0x3][addr & 0x1fff];
+    }
+
+    Byte Mapper::readCHR(Address addr)
+    {
+        return m_chrPages[(addr >> 10) & 0x7][addr & 0x3ff];
+    }
+
+    void Mapper::mapPRG(int first, int count, const Byte* bank)
+    {
+        for (int i = 0; i < count; ++i)
+            m_prgPages[first + i] = bank + i * 0x2000;
+    }
+
+    void Mapper::mapCHR(int first, int count, const Byte* bank)
+    {
+        for (int i = 0; i < count; ++i)
+            m_chrPages[first + i] = bank + i * 0x400;
+    }
+
+    //Pages are saved as offsets into the ROM, so the state can be loaded into another instance of the
+    //same cartridge. Pages of the mapper's own CHR RAM are always mapped to the same page of it.
+    const std::uint32_t OwnMemoryPage = UINT32_MAX;
+
+    void Mapper::saveState(StateWriter& state)
+    {
+        auto& rom = m_cartridge.getROM();
+        for (auto page : m_prgPages)
+            state.write(static_cast<std::uint32_t>(page - rom.data()));
+
+        auto& vrom = m_cartridge.getVROM();
+        for (auto page : m_chrPages)
+        {
+            if (page >= vrom.data() && page < vrom.data() + vrom.size())
+                state.write(static_cast<std::uint32_t>(page - vrom.data()));
+            else
+                state.write(OwnMemoryPage);
+        }
+    }
+
+    void Mapper::loadState(StateReader& state)
+    {
+        //Only whole pages inside the memory they're from, anything else is a damaged state
+        auto& rom = m_cartridge.getROM();
+        for (auto& page : m_prgPages)
+        {
+            auto offset = state.read<std::uint32_t>();
+            if (offset % 0x2000 == 0 && offset + std::size_t(0x2000) <= rom.size())
+                page = rom.data() + offset;
+            else
+                state.fail();
+        }
+
+        auto& vrom = m_cartridge.getVROM();
+        for (std::size_t i = 0; i < m_chrPages.size(); ++i)
+        {
+            auto offset = state.read<std::uint32_t>();
+            if (offset % 0x400 == 0 && offset + std::size_t(0x400) <= vrom.size())
+                m_chrPages[i] = vrom.data() + offset;
+            else if (offset == OwnMemoryPage && (i + 1) * 0x400 <= m_characterRAM.size())
+                m_chrPages[i] = m_characterRAM.data() + i * 0x400;
+            else
+                state.fail();
+        }
+    }
+
     NameTableMirroring Mapper::getNameTableMirroring()
     {
         return static_cast<NameTableMirroring>(m_cartridge.getNameTableMirroring());
     }
 
+    bool Mapper::isSupported(Mapper::Type mapper_t)
+    {
+        switch (mapper_t)
+        {
+            case NROM:
+            case SxROM:
+            case UxROM:
+            case CNROM:
+            case MMC3:
+            case AxROM:
+            case ColorDreams:
+            case GxROM:
+                return true;
+            default:
+                return false;
+        }
+    }
+
     std::unique_ptr<Mapper> Mapper::createMapper(Mapper::Type mapper_t, sn::Cartridge& cart, std::function<void()> interrupt_cb, std::function<void(void)> mirroring_cb)
     {
         std::unique_ptr<Mapper> ret(nullptr);
@@ -18,17 +18,9 @@ namespace sn
             m_characterRAM.resize(0x2000);
             LOG(Info) << "Uses Character RAM OK" << std::endl;
         }
-    }
-
-    Byte MapperAxROM::readPRG(Address address)
-    {
-        if (address >= 0x8000)
-        {
-
-            return m_cartridge.getROM()[m_prgBank * 0x8000 + (address & 0x7FFF)];
-        }
 
-        return 0;
+        mapPRG(0, 4, &cart.getROM()[0]);
+        mapCHR(0, 8, m_characterRAM.empty() ? cart.getVROM().data() : m_characterRAM.data());
     }
 
     void MapperAxROM::writePRG(Address address, Byte value)
@@ -36,6 +28,7 @@ namespace sn
         if (address >= 0x8000)
         {
             m_prgBank = value & 0x07;
+            mapPRG(0, 4, &m_cartridge.getROM()[m_prgBank * 0x8000]);
             m_mirroring = (value & 0x10) ? OneScreenHigher : OneScreenLower;
             m_mirroringCallback();
         }
@@ -46,22 +39,28 @@ namespace sn
         return m_mirroring;
     }
 
-    Byte MapperAxROM::readCHR(Address address)
+    void MapperAxROM::writeCHR(Address address, Byte value)
     {
         if (address < 0x2000)
         {
-            return m_characterRAM[address];
+            m_characterRAM[address] = value;
         }
+    }
 
-        return 0;
+    void MapperAxROM::saveState(StateWriter& state)
+    {
+        Mapper::saveState(state);
+        state.write(m_mirroring);
+        state.write(m_prgBank);
+        state.write(m_characterRAM);
     }
 
-    void MapperAxROM::writeCHR(Address address, Byte value)
+    void MapperAxROM::loadState(StateReader& state)
     {
-        if (address < 0x2000)
-        {
-            m_characterRAM[address] = value;
-        }
+        Mapper::loadState(state);
+        state.read(m_mirroring);
+        state.read(m_prgBank);
+        state.read(m_characterRAM);
     }
 
 }
@@ -15,28 +15,33 @@ namespace sn
         {
             m_oneBank = false;
         }
-    }
 
-    Byte MapperCNROM::readPRG(Address addr)
-    {
-        if (!m_oneBank)
-            return m_cartridge.getROM()[addr - 0x8000];
-        else //mirrored
-            return m_cartridge.getROM()[(addr - 0x8000) & 0x3fff];
+        mapPRG(0, 2, &cart.getROM()[0]);
+        mapPRG(2, 2, &cart.getROM()[m_oneBank ? 0 : 0x4000]); //mirrored if only one bank
+        mapCHR(0, 8, cart.getVROM().data());
     }
 
     void MapperCNROM::writePRG(Address, Byte value)
     {
         m_selectCHR = value & 0x3;
+        mapCHR(0, 8, &m_cartridge.getVROM()[m_selectCHR << 13]);
     }
 
-    Byte MapperCNROM::readCHR(Address addr)
+    void MapperCNROM::writeCHR(Address addr, Byte)
     {
-        return m_cartridge.getVROM()[addr | (m_selectCHR << 13)];
+        LOG(Info) << "Read-only CHR memory write attempt at " << std::hex << addr << std::endl;
     }
 
-    void MapperCNROM::writeCHR(Address addr, Byte)
+    void MapperCNROM::saveState(StateWriter& state)
     {
-        LOG(Info) << "Read-only CHR memory write attempt at " << std::hex << addr << std::endl;
+        Mapper::saveState(state);
+        state.write(m_selectCHR);
     }
+
+    void MapperCNROM::loadState(StateReader& state)
+    {
+        Mapper::loadState(state);
+        state.read(m_selectCHR);
+    }
+
 }
@@ -7,17 +7,12 @@ namespace sn
     MapperColorDreams::MapperColorDreams(Cartridge &cart,std::function<void(void)> mirroring_cb) :
         Mapper(cart, Mapper::ColorDreams),
         m_mirroring(Vertical),
+        prgbank(0),
+        chrbank(0),
         m_mirroringCallback(mirroring_cb)
-    {}
-
-
-    Byte MapperColorDreams::readPRG(Address address)
     {
-        if (address >= 0x8000)
-        {
-            return  m_cartridge.getROM()[(prgbank * 0x8000) + (address & 0x7fff)];
-        }
-        return 0;
+        mapPRG(0, 4, &cart.getROM()[0]);
+        mapCHR(0, 8, cart.getVROM().data());
     }
 
 
@@ -27,27 +22,35 @@ namespace sn
         {
             prgbank = ((value >> 0) & 0x3);
             chrbank = ((value  >> 4) & 0xF);
+            mapPRG(0, 4, &m_cartridge.getROM()[prgbank * 0x8000]);
+            mapCHR(0, 8, &m_cartridge.getVROM()[chrbank * 0x2000]);
 
         }
     }
 
 
-    Byte MapperColorDreams::readCHR(Address address)
+    NameTableMirroring MapperColorDreams::getNameTableMirroring()
     {
-        if (address <= 0x1FFF)
-        {
-            return   m_cartridge.getVROM()[(chrbank * 0x2000) + address];
-        }
-
-        return 0;
+        return m_mirroring;
     }
 
 
-    NameTableMirroring MapperColorDreams::getNameTableMirroring()
+    void MapperColorDreams::writeCHR(Address, Byte) {}
+
+    void MapperColorDreams::saveState(StateWriter& state)
     {
-        return m_mirroring;
+        Mapper::saveState(state);
+        state.write(m_mirroring);
+        state.write(prgbank);
+        state.write(chrbank);
     }
 
+    void MapperColorDreams::loadState(StateReader& state)
+    {
+        Mapper::loadState(state);
+        state.read(m_mirroring);
+        state.read(prgbank);
+        state.read(chrbank);
+    }
 
-    void MapperColorDreams::writeCHR(Address, Byte) {}
 }
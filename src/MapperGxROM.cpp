@@ -5,18 +5,13 @@ namespace sn
 
     MapperGxROM::MapperGxROM(Cartridge &cart, std::function<void(void)> mirroring_cb) :
         Mapper(cart, Mapper::GxROM),
+        prgbank(0),
+        chrbank(0),
         m_mirroring(Vertical),
         m_mirroringCallback(mirroring_cb)
-    {}
-
-    Byte MapperGxROM::readPRG(Address address)
     {
-        if (address >= 0x8000)
-        {
-            return m_cartridge.getROM()[(prgbank * 0x8000) + (address & 0x7fff)];
-        }
-
-        return 0;
+        mapPRG(0, 4, &cart.getROM()[0]);
+        mapCHR(0, 8, cart.getVROM().data());
     }
 
     void MapperGxROM::writePRG(Address address, Byte value)
@@ -25,20 +20,13 @@ namespace sn
         {
             prgbank = ((value & 0x30) >> 4);
             chrbank = (value & 0x3);
+            mapPRG(0, 4, &m_cartridge.getROM()[prgbank * 0x8000]);
+            mapCHR(0, 8, &m_cartridge.getVROM()[chrbank * 0x2000]);
             m_mirroring = Vertical;
         }
         m_mirroringCallback();
     }
 
-    Byte MapperGxROM::readCHR(Address address)
-    {
-        if (address <= 0x1FFF)
-        {
-            return m_cartridge.getVROM()[chrbank * 0x2000 + address];
-        }
-        return 0;
-    }
-
     NameTableMirroring MapperGxROM::getNameTableMirroring()
     {
         return m_mirroring;
@@ -48,4 +36,23 @@ namespace sn
     {
         LOG(Info) << "not expecting writes here";
     }
+
+    void MapperGxROM::saveState(StateWriter& state)
+    {
+        Mapper::saveState(state);
+        state.write(m_mirroring);
+        state.write(prgbank);
+        state.write(chrbank);
+        state.write(m_characterRAM);
+    }
+
+    void MapperGxROM::loadState(StateReader& state)
+    {
+        Mapper::loadState(state);
+        state.read(m_mirroring);
+        state.read(prgbank);
+        state.read(chrbank);
+        state.read(m_characterRAM);
+    }
+
 }
@@ -19,10 +19,10 @@ namespace sn
         m_mirroringCallback(mirroring_cb),
         m_interruptCallback(interrupt_cb)
     {
-        m_prgBank0 = &cart.getROM()[cart.getROM().size() - 0x4000];
-        m_prgBank1 = &cart.getROM()[cart.getROM().size() - 0x2000];
-        m_prgBank2 = &cart.getROM()[cart.getROM().size() - 0x4000];
-        m_prgBank3 = &cart.getROM()[cart.getROM().size() - 0x2000];
+        mapPRG(0, 1, &cart.getROM()[cart.getROM().size() - 0x4000]);
+        mapPRG(1, 1, &cart.getROM()[cart.getROM().size() - 0x2000]);
+        mapPRG(2, 1, &cart.getROM()[cart.getROM().size() - 0x4000]);
+        mapPRG(3, 1, &cart.getROM()[cart.getROM().size() - 0x2000]);
 
 
         for (auto& bank: m_chrBanks)
@@ -31,51 +31,16 @@ namespace sn
         }
         m_chrBanks[0] = cart.getVROM().size() - 0x800;
         m_chrBanks[3] = cart.getVROM().size() - 0x800;
+        updateCHRPages();
     }
 
 
-    Byte MapperMMC3::readPRG(Address addr)
-    {
-        if (addr >= 0x6000 && addr <= 0x7FFF)
-        {
-            return  m_prgRam[addr & 0x1fff];
-        }
-
-
-        if (addr >= 0x8000 && addr <= 0x9FFF)
-        {
-            return *(m_prgBank0 + (addr & 0x1fff));
-        }
-
-        if (addr >= 0xA000 && addr <= 0xBFFF)
-        {
-            return   *(m_prgBank1 + (addr & 0x1fff));
-        }
-
-        if (addr >= 0xC000 && addr <= 0xDFFF)
-        {
-            return *(m_prgBank2 + (addr & 0x1fff));
-        }
-
-        if (addr >= 0xE000)
-        {
-            return *(m_prgBank3  +  (addr & 0x1fff));
-        }
-
-        return 0;
-    }
-
 
     Byte MapperMMC3::readCHR(Address addr)
     {
-        if (addr < 0x1fff)
+        if (addr < 0x2000)
         {
-            // select 1kb bank
-            const auto bankSelect = addr >> 10;
-            // get the configured base address for the bank
-            const auto baseAddress = m_chrBanks[bankSelect];
-            const auto offset = addr & 0x3ff;
-            return m_cartridge.getVROM()[baseAddress + offset];
+            return Mapper::readCHR(addr);
         }
         else if (addr <= 0x2fff)
         {
@@ -132,20 +97,22 @@ namespace sn
 
                 }
 
+                updateCHRPages();
+
                 if (m_prgBankMode == 0)
                 {
                     // ignore top two bits for R6 / R7 using 0x3F
-                    m_prgBank0 = &m_cartridge.getROM()[(m_bankRegister[6] & 0x3F) * 0x2000];
-                    m_prgBank1 = &m_cartridge.getROM()[(m_bankRegister[7] & 0x3F) * 0x2000];
-                    m_prgBank2 = &m_cartridge.getROM()[m_cartridge.getROM().size() - 0x4000];
-                    m_prgBank3 = &m_cartridge.getROM()[m_cartridge.getROM().size() - 0x2000];
+                    mapPRG(0, 1, &m_cartridge.getROM()[(m_bankRegister[6] & 0x3F) * 0x2000]);
+                    mapPRG(1, 1, &m_cartridge.getROM()[(m_bankRegister[7] & 0x3F) * 0x2000]);
+                    mapPRG(2, 1, &m_cartridge.getROM()[m_cartridge.getROM().size() - 0x4000]);
+                    mapPRG(3, 1, &m_cartridge.getROM()[m_cartridge.getROM().size() - 0x2000]);
                 }
                 else if (m_prgBankMode == 1)
                 {
-                    m_prgBank0 = &m_cartridge.getROM()[m_cartridge.getROM().size() - 0x4000];
-                    m_prgBank1 = &m_cartridge.getROM()[(m_bankRegister[7] & 0x3F) * 0x2000];
-                    m_prgBank2 = &m_cartridge.getROM()[(m_bankRegister[6] & 0x3F) * 0x2000];
-                    m_prgBank3 = &m_cartridge.getROM()[m_cartridge.getROM().size() - 0x2000];
+                    mapPRG(0, 1, &m_cartridge.getROM()[m_cartridge.getROM().size() - 0x4000]);
+                    mapPRG(1, 1, &m_cartridge.getROM()[(m_bankRegister[7] & 0x3F) * 0x2000]);
+                    mapPRG(2, 1, &m_cartridge.getROM()[(m_bankRegister[6] & 0x3F) * 0x2000]);
+                    mapPRG(3, 1, &m_cartridge.getROM()[m_cartridge.getROM().size() - 0x2000]);
                 }
             }
 
@@ -197,6 +164,13 @@ namespace sn
     }
 
 
+    void MapperMMC3::updateCHRPages()
+    {
+        for (int i = 0; i < 8; ++i)
+            mapCHR(i, 1, m_cartridge.getVROM().data() + m_chrBanks[i]);
+    }
+
+
     void MapperMMC3::writeCHR(Address addr, Byte value)
     {
         if (addr >= 0x2000 && addr <= 0x2fff)
@@ -233,4 +207,38 @@ namespace sn
         return m_mirroring;
     }
 
+    void MapperMMC3::saveState(StateWriter& state)
+    {
+        Mapper::saveState(state);
+        state.write(m_targetRegister);
+        state.write(m_prgBankMode);
+        state.write(m_chrInversion);
+        state.write(m_bankRegister);
+        state.write(m_irqEnabled);
+        state.write(m_irqCounter);
+        state.write(m_irqLatch);
+        state.write(m_irqReloadPending);
+        state.write(m_prgRam);
+        state.write(m_mirroringRam);
+        state.write(m_chrBanks);
+        state.write(m_mirroring);
+    }
+
+    void MapperMMC3::loadState(StateReader& state)
+    {
+        Mapper::loadState(state);
+        state.read(m_targetRegister);
+        state.read(m_prgBankMode);
+        state.read(m_chrInversion);
+        state.read(m_bankRegister);
+        state.read(m_irqEnabled);
+        state.read(m_irqCounter);
+        state.read(m_irqLatch);
+        state.read(m_irqReloadPending);
+        state.read(m_prgRam);
+        state.read(m_mirroringRam);
+        state.read(m_chrBanks);
+        state.read(m_mirroring);
+    }
+
 } // namespace sn
@@ -23,14 +23,10 @@ namespace sn
         }
         else
             m_usesCharacterRAM = false;
-    }
 
-    Byte MapperNROM::readPRG(Address addr)
-    {
-        if (!m_oneBank)
-            return m_cartridge.getROM()[addr - 0x8000];
-        else //mirrored
-            return m_cartridge.getROM()[(addr - 0x8000) & 0x3fff];
+        mapPRG(0, 2, &cart.getROM()[0]);
+        mapPRG(2, 2, &cart.getROM()[m_oneBank ? 0 : 0x4000]); //mirrored if only one bank
+        mapCHR(0, 8, m_usesCharacterRAM ? m_characterRAM.data() : cart.getVROM().data());
     }
 
     void MapperNROM::writePRG(Address addr, Byte value)
@@ -38,14 +34,6 @@ namespace sn
         LOG(InfoVerbose) << "ROM memory write attempt at " << +addr << " to set " << +value << std::endl;
     }
 
-    Byte MapperNROM::readCHR(Address addr)
-    {
-        if (m_usesCharacterRAM)
-            return m_characterRAM[addr];
-        else
-            return m_cartridge.getVROM()[addr];
-    }
-
     void MapperNROM::writeCHR(Address addr, Byte value)
     {
         if (m_usesCharacterRAM)
@@ -53,4 +41,17 @@ namespace sn
         else
             LOG(Info) << "Read-only CHR memory write attempt at " << std::hex << addr << std::endl;
     }
+
+    void MapperNROM::saveState(StateWriter& state)
+    {
+        Mapper::saveState(state);
+        state.write(m_characterRAM);
+    }
+
+    void MapperNROM::loadState(StateReader& state)
+    {
+        Mapper::loadState(state);
+        state.read(m_characterRAM);
+    }
+
 }
@@ -35,14 +35,13 @@ namespace sn
 
         m_firstBankPRG = &cart.getROM()[0]; //first bank
         m_secondBankPRG = &cart.getROM()[cart.getROM().size() - 0x4000/*0x2000 * 0x0e*/]; //last bank
-    }
 
-    Byte MapperSxROM::readPRG(Address addr)
-    {
-        if (addr < 0xc000)
-            return *(m_firstBankPRG + (addr & 0x3fff));
+        mapPRG(0, 2, m_firstBankPRG);
+        mapPRG(2, 2, m_secondBankPRG);
+        if (m_usesCharacterRAM)
+            mapCHR(0, 8, m_characterRAM.data());
         else
-            return *(m_secondBankPRG + (addr & 0x3fff));
+            updateCHRPages();
     }
 
     NameTableMirroring MapperSxROM::getNameTableMirroring()
@@ -112,6 +111,9 @@ namespace sn
                     calculatePRGPointers();
                 }
 
+                if (!m_usesCharacterRAM)
+                    updateCHRPages();
+
                 m_tempRegister = 0;
                 m_writeCounter = 0;
             }
@@ -143,16 +145,15 @@ namespace sn
             m_firstBankPRG = &m_cartridge.getROM()[0x4000 * m_regPRG];
             m_secondBankPRG = &m_cartridge.getROM()[m_cartridge.getROM().size() - 0x4000/*0x2000 * 0x0e*/];
         }
+
+        mapPRG(0, 2, m_firstBankPRG);
+        mapPRG(2, 2, m_secondBankPRG);
     }
 
-    Byte MapperSxROM::readCHR(Address addr)
+    void MapperSxROM::updateCHRPages()
     {
-        if (m_usesCharacterRAM)
-            return m_characterRAM[addr];
-        else if (addr < 0x1000)
-            return *(m_firstBankCHR + addr);
-        else
-            return *(m_secondBankCHR + (addr & 0xfff));
+        mapCHR(0, 4, m_firstBankCHR);
+        mapCHR(4, 4, m_secondBankCHR);
     }
 
     void MapperSxROM::writeCHR(Address addr, Byte value)
@@ -162,4 +163,42 @@ namespace sn
         else
             LOG(Info) << "Read-only CHR memory write attempt at " << std::hex << addr << std::endl;
     }
+
+    void MapperSxROM::saveState(StateWriter& state)
+    {
+        Mapper::saveState(state);
+        state.write(m_mirroing);
+        state.write(m_modeCHR);
+        state.write(m_modePRG);
+        state.write(m_tempRegister);
+        state.write(m_writeCounter);
+        state.write(m_regPRG);
+        state.write(m_regCHR0);
+        state.write(m_regCHR1);
+        state.write(m_characterRAM);
+    }
+
+    void MapperSxROM::loadState(StateReader& state)
+    {
+        Mapper::loadState(state);
+        state.read(m_mirroing);
+        state.read(m_modeCHR);
+        state.read(m_modePRG);
+        state.read(m_tempRegister);
+        state.read(m_writeCounter);
+        state.read(m_regPRG);
+        state.read(m_regCHR0);
+        state.read(m_regCHR1);
+        state.read(m_characterRAM);
+
+        //The banks can't always be told from the registers, take them from the pages instead
+        m_firstBankPRG = m_prgPages[0];
+        m_secondBankPRG = m_prgPages[2];
+        if (!m_usesCharacterRAM)
+        {
+            m_firstBankCHR = m_chrPages[0];
+            m_secondBankCHR = m_chrPages[4];
+        }
+    }
+
 }
@@ -17,27 +17,16 @@ namespace sn
             m_usesCharacterRAM = false;
 
         m_lastBankPtr = &cart.getROM()[cart.getROM().size() - 0x4000]; //last - 16KB
-    }
 
-    Byte MapperUxROM::readPRG(Address addr)
-    {
-        if (addr < 0xc000)
-            return m_cartridge.getROM()[((addr - 0x8000) & 0x3fff) | (m_selectPRG << 14)];
-        else
-            return *(m_lastBankPtr + (addr & 0x3fff));
+        mapPRG(0, 2, &cart.getROM()[0]);
+        mapPRG(2, 2, m_lastBankPtr);
+        mapCHR(0, 8, m_usesCharacterRAM ? m_characterRAM.data() : cart.getVROM().data());
     }
 
     void MapperUxROM::writePRG(Address, Byte value)
     {
         m_selectPRG = value;
-    }
-
-    Byte MapperUxROM::readCHR(Address addr)
-    {
-        if (m_usesCharacterRAM)
-            return m_characterRAM[addr];
-        else
-            return m_cartridge.getVROM()[addr];
+        mapPRG(0, 2, &m_cartridge.getROM()[m_selectPRG << 14]);
     }
 
     void MapperUxROM::writeCHR(Address addr, Byte value)
@@ -47,4 +36,19 @@ namespace sn
         else
             LOG(Info) << "Read-only CHR memory write attempt at " << std::hex << addr << std::endl;
     }
+
+    void MapperUxROM::saveState(StateWriter& state)
+    {
+        Mapper::saveState(state);
+        state.write(m_selectPRG);
+        state.write(m_characterRAM);
+    }
+
+    void MapperUxROM::loadState(StateReader& state)
+    {
+        Mapper::loadState(state);
+        state.read(m_selectPRG);
+        state.read(m_characterRAM);
+    }
+
 }
@@ -0,0 +1,77 @@
+#include "Movie.h"
+#include "SaveState.h"
+#include "Log.h"
+#include <fstream>
+#include <iterator>
+
+namespace sn
+{
+    //"SNMV" at the start of every movie file
+    const std::uint32_t MovieMagic = 0x564d4e53;
+    const std::uint32_t MovieVersion = 1;
+
+    Movie::Movie() :
+        m_romHash(0)
+    {}
+
+    void Movie::setInput(std::size_t frame, const Input& input)
+    {
+        m_inputs.resize(frame);
+        m_inputs.push_back(input);
+    }
+
+    bool Movie::saveToFile(const std::string& path)
+    {
+        std::ofstream file (path, std::ios::binary);
+        if (!file)
+        {
+            LOG(Error) << "Could not open " << path << " to save the movie" << std::endl;
+            return false;
+        }
+
+        //Header, the start state, then two bytes of buttons for every frame
+        std::vector<std::uint8_t> buffer;
+        StateWriter writer (buffer);
+        writer.write(MovieMagic);
+        writer.write(MovieVersion);
+        writer.write(m_romHash);
+        writer.write(static_cast<std::uint32_t>(m_startState.size()));
+        writer.write(m_startState);
+        writer.write(static_cast<std::uint32_t>(m_inputs.size()));
+        writer.writeBytes(m_inputs.data(), m_inputs.size() * sizeof(Input));
+
+        file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        return file.good();
+    }
+
+    bool Movie::loadFromFile(const std::string& path)
+    {
+        std::ifstream file (path, std::ios::binary);
+        if (!file)
+        {
+            LOG(Error) << "Could not open movie file " << path << std::endl;
+            return false;
+        }
+        std::vector<std::uint8_t> buffer ((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        StateReader reader (buffer.data(), buffer.size());
+        if (reader.read<std::uint32_t>() != MovieMagic || reader.read<std::uint32_t>() != MovieVersion)
+        {
+            LOG(Error) << path << " is not a movie of this version" << std::endl;
+            return false;
+        }
+        reader.read(m_romHash);
+        m_startState.resize(std::min<std::size_t>(reader.read<std::uint32_t>(), buffer.size()));
+        reader.read(m_startState);
+        m_inputs.resize(std::min<std::size_t>(reader.read<std::uint32_t>(), buffer.size() / sizeof(Input)));
+        reader.readBytes(m_inputs.data(), m_inputs.size() * sizeof(Input));
+
+        if (!reader.good() || !reader.atEnd())
+        {
+            LOG(Error) << "Movie file " << path << " is damaged" << std::endl;
+            return false;
+        }
+        LOG(Info) << "Loaded movie of " << m_inputs.size() << " frames" << std::endl;
+        return true;
+    }
+}
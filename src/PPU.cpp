@@ -1,24 +1,65 @@
 #include "PPU.h"
 #include "Log.h"
+#include <algorithm>
 
 namespace sn
 {
-    PPU::PPU(PictureBus& bus, VirtualScreen& screen) :
+    namespace
+    {
+        //The palette once for every combination of emphasis bits (red, green, blue from the lowest). The
+        //colors not emphasized are dimmed, about as much as on a real console. With all three emphasized
+        //every color is dimmed, darkening the whole picture.
+        struct EmphasizedColors
+        {
+            std::uint32_t colors[8][64];
+
+            EmphasizedColors()
+            {
+                for (int emphasis = 0; emphasis < 8; ++emphasis)
+                {
+                    for (int color = 0; color < 64; ++color)
+                    {
+                        std::uint32_t rgba = ::colors[color] & 0xff;
+                        for (int channel = 0; channel < 3; ++channel)
+                        {
+                            std::uint32_t value = (::colors[color] >> (24 - 8 * channel)) & 0xff;
+                            if (emphasis == 7 || (emphasis && !(emphasis & (1 << channel))))
+                                value = value * 3 / 4;
+                            rgba |= value << (24 - 8 * channel);
+                        }
+                        colors[emphasis][color] = rgba;
+                    }
+                }
+            }
+
+            const std::uint32_t* operator[](int emphasis) const { return colors[emphasis]; }
+        } const emphasizedColors;
+    }
+
+    PPU::PPU(PictureBus& bus) :
         m_bus(bus),
-        m_screen(screen),
+        m_outputEnabled(true),
         m_spriteMemory(64 * 4),
-        m_pictureBuffer(ScanlineVisibleDots, std::vector<sf::Color>(VisibleScanlines, sf::Color::Magenta))
+        m_pictureBuffer(ScanlineVisibleDots * VisibleScanlines, 0x0f),
+        m_frame(ScanlineVisibleDots * VisibleScanlines, 0x0f),
+        m_emphasisBuffer(VisibleScanlines),
+        m_frameEmphasis(VisibleScanlines),
+        m_rgbaFrame(ScanlineVisibleDots * VisibleScanlines),
+        m_rgbaPending(true)
     {}
 
     void PPU::reset()
     {
         m_longSprites = m_generateInterrupt = m_greyscaleMode = m_vblank = m_spriteOverflow = false;
+        m_sprZeroHit = m_hideEdgeBackground = m_hideEdgeSprites = false;
+        m_emphasis = m_dataBuffer = 0;
         m_showBackground = m_showSprites = m_evenFrame = m_firstWrite = true;
         m_bgPage = m_sprPage = Low;
         m_dataAddress = m_cycle = m_scanline = m_spriteDataAddress = m_fineXScroll = m_tempAddress = 0;
         //m_baseNameTable = 0x2000;
         m_dataAddrIncrement = 1;
         m_pipelineState = PreRender;
+        m_frameCount = 0;
         m_scanlineSprites.reserve(8);
         m_scanlineSprites.resize(0);
     }
@@ -28,6 +69,252 @@ namespace sn
         m_vblankCallback = cb;
     }
 
+    void PPU::run(int dots)
+    {
+        while (dots > 0)
+        {
+            //Nothing the CPU does can happen in the middle of a run, so the visible dots are drawn in one go,
+            //up to the end of the scanline or of the run
+            if (m_pipelineState == Render && m_cycle > 0 && m_cycle <= ScanlineVisibleDots)
+            {
+                int end = std::min(m_cycle + dots, ScanlineVisibleDots + 1);
+                render(m_cycle - 1, end - 1);
+                dots -= end - m_cycle;
+                m_cycle = end;
+            }
+            else if (int idle = idleDots())
+            {
+                idle = std::min(idle, dots);
+                dots -= idle;
+                m_cycle += idle;
+            }
+            else
+            {
+                step();
+                --dots;
+            }
+        }
+    }
+
+    int PPU::idleDots()
+    {
+        //Up to the end of the line, step() does nothing but count the dots after the scanline IRQ of
+        //a visible line and on the lines after the picture, except where the vblank starts
+        bool idle = m_pipelineState == PostRender ||
+                    (m_pipelineState == VerticalBlank && !(m_scanline == VisibleScanlines + 1 && m_cycle <= 1)) ||
+                    (m_pipelineState == Render && m_cycle > 260);
+        return idle && m_cycle < ScanlineEndCycle ? ScanlineEndCycle - m_cycle : 0;
+    }
+
+    void PPU::render(int x, int end)
+    {
+        int y = m_scanline;
+
+        //Without output the pixels are only worked out where they may set the sprite 0 hit flag
+        int drawFrom = x, drawTo = end;
+        if (!m_outputEnabled)
+        {
+            int spr0_x = m_spriteMemory[3];
+            if (!m_sprZeroHit && m_showBackground && m_showSprites &&
+                !m_scanlineSprites.empty() && m_scanlineSprites[0] == 0)
+            {
+                drawFrom = std::max(x, spr0_x);
+                drawTo = std::min(end, spr0_x + 8);
+            }
+            else
+                drawTo = drawFrom;
+        }
+
+        //Palette entry bits of each pixel, with whether the sprite pixels are behind the background
+        //and from sprite 0 above them. Only [drawFrom, drawTo) is used.
+        Byte bgLine[ScanlineVisibleDots], sprLine[ScanlineVisibleDots];
+        if (drawFrom < drawTo)
+        {
+            std::fill(bgLine + drawFrom, bgLine + drawTo, 0);
+            std::fill(sprLine + drawFrom, sprLine + drawTo, 0);
+        }
+
+        if (m_showBackground)
+        {
+            int bgFrom = std::max(drawFrom, m_hideEdgeBackground ? 8 : 0);
+            //A tile at a time, its name table, attribute and pattern bytes are fetched once for all its pixels
+            for (int tileX = x; tileX < end;)
+            {
+                int x_fine = (m_fineXScroll + tileX) % 8;
+                int tileEnd = std::min(tileX + 8 - x_fine, end);
+
+                int from = std::max(tileX, bgFrom), to = std::min(tileEnd, drawTo);
+                if (from < to)
+                {
+                    //fetch tile
+                    auto addr = 0x2000 | (m_dataAddress & 0x0FFF); //mask off fine y
+                    Byte tile = read(addr);
+
+                    //fetch pattern
+                    //Each pattern occupies 16 bytes, so multiply by 16
+                    addr = (tile * 16) + ((m_dataAddress >> 12/*y % 8*/) & 0x7); //Add fine y
+                    addr |= m_bgPage << 12; //set whether the pattern is in the high or low page
+                    auto pattern = m_bus.readPattern(addr).pixels;
+
+                    //fetch attribute and calculate higher two bits of palette
+                    addr = 0x23C0 | (m_dataAddress & 0x0C00) | ((m_dataAddress >> 4) & 0x38)
+                                | ((m_dataAddress >> 2) & 0x07);
+                    int shift = ((m_dataAddress >> 4) & 4) | (m_dataAddress & 2);
+                    Byte palette = ((read(addr) >> shift) & 0x3) << 2;
+
+                    for (int i = from; i < to; ++i)
+                    {
+                        Byte color = (pattern >> (2 * (x_fine + i - tileX))) & 0x3;
+                        bgLine[i] = color ? palette | color : 0;
+                    }
+                }
+
+                //Increment/wrap coarse X
+                if (x_fine + tileEnd - tileX == 8)
+                {
+                    if ((m_dataAddress & 0x001F) == 31) // if coarse X == 31
+                    {
+                        m_dataAddress &= ~0x001F;          // coarse X = 0
+                        m_dataAddress ^= 0x0400;           // switch horizontal nametable
+                    }
+                    else
+                    {
+                        m_dataAddress += 1;                // increment coarse X
+                    }
+                }
+                tileX = tileEnd;
+            }
+        }
+
+        if (m_showSprites)
+        {
+            int sprFrom = std::max(drawFrom, m_hideEdgeSprites ? 8 : 0);
+            for (auto i : m_scanlineSprites)
+            {
+                int spr_x = m_spriteMemory[i * 4 + 3];
+                int from = std::max(sprFrom, spr_x), to = std::min(drawTo, spr_x + 8);
+                if (from >= to)
+                    continue;
+
+                Byte spr_y     = m_spriteMemory[i * 4 + 0] + 1,
+                     tile      = m_spriteMemory[i * 4 + 1],
+                     attribute = m_spriteMemory[i * 4 + 2];
+
+                int length = (m_longSprites) ? 16 : 8;
+
+                int y_offset = (y - spr_y) % length;
+
+                if ((attribute & 0x80) != 0) //IF flipping vertically
+                    y_offset ^= (length - 1);
+
+                Address addr = 0;
+
+                if (!m_longSprites)
+                {
+                    addr = tile * 16 + y_offset;
+                    if (m_sprPage == High) addr += 0x1000;
+                }
+                else //8x16 sprites
+                {
+                    //bit-3 is one if it is the bottom tile of the sprite, multiply by two to get the next pattern
+                    y_offset = (y_offset & 7) | ((y_offset & 8) << 1);
+                    addr = (tile >> 1) * 32 + y_offset;
+                    addr |= (tile & 1) << 12; //Bank 0x1000 if bit-0 is high
+                }
+
+                auto row = m_bus.readPattern(addr);
+                auto pattern = (attribute & 0x40) ? row.flipped : row.pixels; //If flipping horizontally
+                //Select sprite palette, bits 2-3, priority and whether it's sprite 0
+                Byte info = 0x10 | ((attribute & 0x3) << 2) | (attribute & 0x20) | (i == 0 ? 0x40 : 0);
+
+                for (int j = from; j < to; ++j)
+                {
+                    //The first opaque sprite in the list is the one shown
+                    if (sprLine[j])
+                        continue;
+
+                    Byte color = (pattern >> (2 * (j - spr_x))) & 0x3;
+                    if (color)
+                        sprLine[j] = info | color;
+                }
+            }
+        }
+
+        //Sprite-0 hit detection
+        if (!m_sprZeroHit && m_showBackground)
+        {
+            for (int i = drawFrom; i < drawTo; ++i)
+            {
+                if ((sprLine[i] & 0x40) && bgLine[i])
+                {
+                    m_sprZeroHit = true;
+                    break;
+                }
+            }
+        }
+
+        if (m_outputEnabled && drawFrom < drawTo)
+        {
+            //The palette RAM only has 6 bits, but keeps all 8 written here
+            Byte palette[0x20];
+            for (int i = 0; i < 0x20; ++i)
+                palette[i] = m_bus.readPalette(i) & 0x3f;
+
+            m_emphasisBuffer[y] = m_emphasis;
+            auto pixel = &m_pictureBuffer[y * ScanlineVisibleDots];
+            for (int i = drawFrom; i < drawTo; ++i)
+            {
+                Byte bgColor = bgLine[i], sprColor = sprLine[i];
+                //Sprites in front of the background or where it's transparent
+                Byte paletteAddr = sprColor && (!bgColor || !(sprColor & 0x20)) ? sprColor & 0x1f : bgColor;
+                pixel[i] = palette[paletteAddr];
+            }
+        }
+    }
+
+    int PPU::dotsUntil(int scanline, int cycle)
+    {
+        //Assume the pre-render line will be the short one whenever that's still possible
+        if (m_pipelineState == PreRender)
+            return ScanlineEndCycle - !m_evenFrame - m_cycle + 1 + scanline * ScanlineEndCycle + cycle;
+
+        //Every other line is ScanlineEndCycle dots long
+        int dots = (scanline - m_scanline) * ScanlineEndCycle + cycle - m_cycle + 1;
+        if (dots <= 0) //Already passed in this frame, the next one flips m_evenFrame
+            dots += FrameEndScanline * ScanlineEndCycle + ScanlineEndCycle - m_evenFrame;
+        return dots;
+    }
+
+    int PPU::dotsUntilVBlank()
+    {
+        return dotsUntil(VisibleScanlines + 1, 1);
+    }
+
+    int PPU::dotsUntilFrameEnd()
+    {
+        return dotsUntil(VisibleScanlines, ScanlineEndCycle);
+    }
+
+    int PPU::dotsUntilScanlineIRQ()
+    {
+        if (!m_showBackground || !m_showSprites)
+            return -1;
+
+        const int irqCycle = 260;
+        switch (m_pipelineState)
+        {
+            case PreRender:
+            case Render:
+                if (m_cycle <= irqCycle)
+                    return irqCycle - m_cycle + 1;
+                //Next line, which may turn out to be the post-render one
+                return ScanlineEndCycle - (m_pipelineState == PreRender) - m_cycle + 1 + irqCycle;
+            default:
+                //Pre-render line of the next frame
+                return (FrameEndScanline - m_scanline) * ScanlineEndCycle - m_cycle + 1 + irqCycle;
+        }
+    }
+
     void PPU::step()
     {
         switch (m_pipelineState)
@@ -64,127 +351,7 @@ namespace sn
             case Render:
                 if (m_cycle > 0 && m_cycle <= ScanlineVisibleDots)
                 {
-                    Byte bgColor = 0, sprColor = 0;
-                    bool bgOpaque = false, sprOpaque = true;
-                    bool spriteForeground = false;
-
-                    int x = m_cycle - 1;
-                    int y = m_scanline;
-
-                    if (m_showBackground)
-                    {
-                        auto x_fine = (m_fineXScroll + x) % 8;
-                        if (!m_hideEdgeBackground || x >= 8)
-                        {
-                            //fetch tile
-                            auto addr = 0x2000 | (m_dataAddress & 0x0FFF); //mask off fine y
-                            //auto addr = 0x2000 + x / 8 + (y / 8) * (ScanlineVisibleDots / 8);
-                            Byte tile = read(addr);
-
-                            //fetch pattern
-                            //Each pattern occupies 16 bytes, so multiply by 16
-                            addr = (tile * 16) + ((m_dataAddress >> 12/*y % 8*/) & 0x7); //Add fine y
-                            addr |= m_bgPage << 12; //set whether the pattern is in the high or low page
-                            //Get the corresponding bit determined by (8 - x_fine) from the right
-                            bgColor = (read(addr) >> (7 ^ x_fine)) & 1; //bit 0 of palette entry
-                            bgColor |= ((read(addr + 8) >> (7 ^ x_fine)) & 1) << 1; //bit 1
-
-                            bgOpaque = bgColor; //flag used to calculate final pixel with the sprite pixel
-
-                            //fetch attribute and calculate higher two bits of palette
-                            addr = 0x23C0 | (m_dataAddress & 0x0C00) | ((m_dataAddress >> 4) & 0x38)
-                                        | ((m_dataAddress >> 2) & 0x07);
-                            auto attribute = read(addr);
-                            int shift = ((m_dataAddress >> 4) & 4) | (m_dataAddress & 2);
-                            //Extract and set the upper two bits for the color
-                            bgColor |= ((attribute >> shift) & 0x3) << 2;
-                        }
-                        //Increment/wrap coarse X
-                        if (x_fine == 7)
-                        {
-                            if ((m_dataAddress & 0x001F) == 31) // if coarse X == 31
-                            {
-                                m_dataAddress &= ~0x001F;          // coarse X = 0
-                                m_dataAddress ^= 0x0400;           // switch horizontal nametable
-                            }
-                            else
-                            {
-                                m_dataAddress += 1;                // increment coarse X
-                            }
-                        }
-                    }
-
-                    if (m_showSprites && (!m_hideEdgeSprites || x >= 8))
-                    {
-                        for (auto i : m_scanlineSprites)
-                        {
-                            Byte spr_x =     m_spriteMemory[i * 4 + 3];
-
-                            if (0 > x - spr_x || x - spr_x >= 8)
-                                continue;
-
-                            Byte spr_y     = m_spriteMemory[i * 4 + 0] + 1,
-                                 tile      = m_spriteMemory[i * 4 + 1],
-                                 attribute = m_spriteMemory[i * 4 + 2];
-
-                            int length = (m_longSprites) ? 16 : 8;
-
-                            int x_shift = (x - spr_x) % 8, y_offset = (y - spr_y) % length;
-
-                            if ((attribute & 0x40) == 0) //If NOT flipping horizontally
-                                x_shift ^= 7;
-                            if ((attribute & 0x80) != 0) //IF flipping vertically
-                                y_offset ^= (length - 1);
-
-                            Address addr = 0;
-
-                            if (!m_longSprites)
-                            {
-                                addr = tile * 16 + y_offset;
-                                if (m_sprPage == High) addr += 0x1000;
-                            }
-                            else //8x16 sprites
-                            {
-                                //bit-3 is one if it is the bottom tile of the sprite, multiply by two to get the next pattern
-                                y_offset = (y_offset & 7) | ((y_offset & 8) << 1);
-                                addr = (tile >> 1) * 32 + y_offset;
-                                addr |= (tile & 1) << 12; //Bank 0x1000 if bit-0 is high
-                            }
-
-                            sprColor |= (read(addr) >> (x_shift)) & 1; //bit 0 of palette entry
-                            sprColor |= ((read(addr + 8) >> (x_shift)) & 1) << 1; //bit 1
-
-                            if (!(sprOpaque = sprColor))
-                            {
-                                sprColor = 0;
-                                continue;
-                            }
-
-                            sprColor |= 0x10; //Select sprite palette
-                            sprColor |= (attribute & 0x3) << 2; //bits 2-3
-
-                            spriteForeground = !(attribute & 0x20);
-
-                            //Sprite-0 hit detection
-                            if (!m_sprZeroHit && m_showBackground && i == 0 && sprOpaque && bgOpaque)
-                            {
-                                m_sprZeroHit = true;
-                            }
-
-                            break; //Exit the loop now since we've found the highest priority sprite
-                        }
-                    }
-
-                    Byte paletteAddr = bgColor;
-
-                    if ( (!bgOpaque && sprOpaque) ||
-                         (bgOpaque && sprOpaque && spriteForeground) )
-                        paletteAddr = sprColor;
-                    else if (!bgOpaque && !sprOpaque)
-                        paletteAddr = 0;
-                    //else bgColor
-
-                    m_pictureBuffer[x][y] = sf::Color(colors[m_bus.readPalette(paletteAddr)]);
+                    render(m_cycle - 1, m_cycle);
                 }
                 else if (m_cycle == ScanlineVisibleDots + 1 && m_showBackground)
                 {
@@ -268,13 +435,15 @@ namespace sn
                     m_cycle = 0;
                     m_pipelineState = VerticalBlank;
 
-                    for (std::size_t x = 0; x < m_pictureBuffer.size(); ++x)
+                    //Every visible pixel is drawn each frame, so the old one can simply be drawn over.
+                    //A frame finished without output keeps the last one drawn.
+                    if (m_outputEnabled)
                     {
-                        for (std::size_t y = 0; y < m_pictureBuffer[0].size(); ++y)
-                        {
-                            m_screen.setPixel(x, y, m_pictureBuffer[x][y]);
-                        }
+                        m_pictureBuffer.swap(m_frame);
+                        m_emphasisBuffer.swap(m_frameEmphasis);
+                        m_rgbaPending = true;
                     }
+                    ++m_frameCount;
 
                 }
 
@@ -307,6 +476,24 @@ namespace sn
         ++m_cycle;
     }
 
+    const std::vector<std::uint32_t>& PPU::getFrame()
+    {
+        if (m_rgbaPending)
+        {
+            for (int y = 0; y < VisibleScanlines; ++y)
+            {
+                //One table lookup per pixel, little next to drawing them
+                auto table = emphasizedColors[m_frameEmphasis[y]];
+                auto in = &m_frame[y * ScanlineVisibleDots];
+                auto out = &m_rgbaFrame[y * ScanlineVisibleDots];
+                for (int x = 0; x < ScanlineVisibleDots; ++x)
+                    out[x] = table[in[x]];
+            }
+            m_rgbaPending = false;
+        }
+        return m_rgbaFrame;
+    }
+
     Byte PPU::readOAM(Byte addr)
     {
         return m_spriteMemory[addr];
@@ -348,6 +535,7 @@ namespace sn
         m_hideEdgeSprites = !(mask & 0x4);
         m_showBackground = mask & 0x8;
         m_showSprites = mask & 0x10;
+        m_emphasis = mask >> 5;
     }
 
     Byte PPU::getStatus()
@@ -440,4 +628,88 @@ namespace sn
         return m_bus.read(addr);
     }
 
+    void PPU::saveState(StateWriter& state)
+    {
+        state.write(m_spriteMemory);
+        state.write(static_cast<Byte>(m_scanlineSprites.size()));
+        state.write(m_scanlineSprites);
+
+        state.write(m_pipelineState);
+        state.write(m_cycle);
+        state.write(m_scanline);
+        state.write(m_evenFrame);
+        state.write(m_frameCount);
+
+        state.write(m_vblank);
+        state.write(m_sprZeroHit);
+        state.write(m_spriteOverflow);
+
+        state.write(m_dataAddress);
+        state.write(m_tempAddress);
+        state.write(m_fineXScroll);
+        state.write(m_firstWrite);
+        state.write(m_dataBuffer);
+        state.write(m_spriteDataAddress);
+
+        state.write(m_longSprites);
+        state.write(m_generateInterrupt);
+        state.write(m_greyscaleMode);
+        state.write(m_emphasis);
+        state.write(m_showSprites);
+        state.write(m_showBackground);
+        state.write(m_hideEdgeSprites);
+        state.write(m_hideEdgeBackground);
+        state.write(m_bgPage);
+        state.write(m_sprPage);
+        state.write(m_dataAddrIncrement);
+    }
+
+    void PPU::loadState(StateReader& state)
+    {
+        state.read(m_spriteMemory);
+        //At most 8 sprites of the 64 are on a line, more is a damaged state
+        auto sprites = state.read<Byte>();
+        if (sprites > 8)
+        {
+            state.fail();
+            sprites = 0;
+        }
+        m_scanlineSprites.resize(sprites);
+        state.read(m_scanlineSprites);
+        for (auto sprite : m_scanlineSprites)
+        {
+            if (sprite >= 64)
+                state.fail();
+        }
+
+        state.read(m_pipelineState);
+        state.read(m_cycle);
+        state.read(m_scanline);
+        state.read(m_evenFrame);
+        state.read(m_frameCount);
+
+        state.read(m_vblank);
+        state.read(m_sprZeroHit);
+        state.read(m_spriteOverflow);
+
+        state.read(m_dataAddress);
+        state.read(m_tempAddress);
+        state.read(m_fineXScroll);
+        state.read(m_firstWrite);
+        state.read(m_dataBuffer);
+        state.read(m_spriteDataAddress);
+
+        state.read(m_longSprites);
+        state.read(m_generateInterrupt);
+        state.read(m_greyscaleMode);
+        state.read(m_emphasis);
+        state.read(m_showSprites);
+        state.read(m_showBackground);
+        state.read(m_hideEdgeSprites);
+        state.read(m_hideEdgeBackground);
+        state.read(m_bgPage);
+        state.read(m_sprPage);
+        state.read(m_dataAddrIncrement);
+    }
+
 }
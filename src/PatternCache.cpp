@@ -0,0 +1,47 @@
+#include "PatternCache.h"
+
+namespace sn
+{
+    PatternCache::PatternCache() :
+        m_slots(Slots)
+    {
+        clear();
+    }
+
+    void PatternCache::invalidate(const std::uint8_t* page, std::size_t offset)
+    {
+        auto& slot = getSlot(page);
+        if (slot.page == page)
+            slot.decoded &= ~(std::uint64_t(1) << (offset >> 4));
+    }
+
+    void PatternCache::clear()
+    {
+        for (auto& slot : m_slots)
+        {
+            slot.page = nullptr;
+            slot.decoded = 0;
+        }
+    }
+
+    PatternRow PatternCache::decode(std::uint8_t low, std::uint8_t high)
+    {
+        PatternRow row {0, 0};
+        for (int i = 0; i < 8; ++i)
+        {
+            //Bit 7 of each plane is the leftmost pixel
+            std::uint16_t color = ((low >> (7 - i)) & 1) | (((high >> (7 - i)) & 1) << 1);
+            row.pixels |= color << (2 * i);
+            row.flipped |= color << (2 * (7 - i));
+        }
+        return row;
+    }
+
+    void PatternCache::decodeTile(Slot& slot, std::size_t tile)
+    {
+        auto pattern = slot.page + tile * 16;
+        for (int y = 0; y < 8; ++y)
+            slot.rows[tile * 8 + y] = decode(pattern[y], pattern[y + 8]);
+        slot.decoded |= std::uint64_t(1) << tile;
+    }
+}
@@ -14,7 +14,8 @@ namespace sn
     {
         if (addr < 0x2000)
         {
-            return m_mapper->readCHR(addr);
+            auto page = m_mapper->getCHRPage(addr);
+            return page ? page[addr & 0x3ff] : m_mapper->readCHR(addr);
         }
         else if (addr < 0x3eff)
         {
@@ -45,6 +46,18 @@ namespace sn
         return 0;
     }
 
+    PatternRow PictureBus::readPattern(Address addr)
+    {
+        //Rows starting in the second plane only happen when sprites are moved after being evaluated
+        if (addr < 0x2000 && !(addr & 8))
+        {
+            auto page = m_mapper->getCHRPage(addr);
+            if (page)
+                return m_patterns.getRow(page, addr & 0x3ff);
+        }
+        return PatternCache::decode(read(addr), read(addr + 8));
+    }
+
     Byte PictureBus::readPalette(Byte paletteAddr)
     {
         // Addresses $3F10/$3F14/$3F18/$3F1C are mirrors of $3F00/$3F04/$3F08/$3F0C
@@ -59,6 +72,9 @@ namespace sn
         if (addr < 0x2000)
         {
             m_mapper->writeCHR(addr, value);
+            auto page = m_mapper->getCHRPage(addr);
+            if (page)
+                m_patterns.invalidate(page, addr & 0x3ff);
         }
         else if (addr < 0x3eff)
         {
@@ -133,6 +149,7 @@ namespace sn
         }
 
         m_mapper = mapper;
+        m_patterns.clear();
         updateMirroring();
         return true;
     }
@@ -140,4 +157,20 @@ namespace sn
     void PictureBus::scanlineIRQ(){
         m_mapper->scanlineIRQ();
     }
+
+    void PictureBus::saveState(StateWriter& state)
+    {
+        state.write(m_palette);
+        state.write(m_RAM);
+    }
+
+    void PictureBus::loadState(StateReader& state)
+    {
+        state.read(m_palette);
+        state.read(m_RAM);
+        //CHR RAM was loaded with the mapper
+        m_patterns.clear();
+        updateMirroring();
+    }
+
 }
@@ -0,0 +1,29 @@
+#include "Profiler.h"
+
+namespace sn
+{
+    Profiler::Profiler() :
+        m_enabled(false)
+    {
+        reset();
+    }
+
+    void Profiler::reset()
+    {
+        m_times.fill(std::chrono::nanoseconds::zero());
+    }
+
+    Profiler::Scope::Scope(Profiler* profiler, Section section) :
+        m_profiler(profiler && profiler->isEnabled() ? profiler : nullptr),
+        m_section(section)
+    {
+        if (m_profiler)
+            m_start = Clock::now();
+    }
+
+    Profiler::Scope::~Scope()
+    {
+        if (m_profiler)
+            m_profiler->m_times[m_section] += Clock::now() - m_start;
+    }
+}
@@ -0,0 +1,254 @@
+#include "ROMIndex.h"
+#include "SaveState.h"
+#include "Log.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SN_LIST_DIRECTORIES
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+namespace sn
+{
+    namespace
+    {
+        //"SNRI" at the start of every index
+        const std::uint32_t ROMIndexMagic = 0x49524e53;
+        const std::uint32_t ROMIndexVersion = 1;
+        //Magic, version, number of entries and size of the paths
+        const std::size_t ROMIndexHeaderSize = 16;
+
+        static_assert(sizeof(ROMIndex::Entry) == 32, "Index entries are laid out as in the file");
+
+        bool isROMFile(const std::string& name)
+        {
+            if (name.size() < 4)
+                return false;
+            auto extension = name.substr(name.size() - 4);
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+            return extension == ".nes";
+        }
+
+        //Appends the paths of the .nes files in root/relative and below, relative to root, to files.
+        //False if root/relative can't be read.
+        bool listFiles(const std::string& root, const std::string& relative, std::vector<std::string>& files)
+        {
+#ifdef SN_LIST_DIRECTORIES
+            auto dir = opendir((relative.empty() ? root : root + '/' + relative).c_str());
+            if (!dir)
+                return false;
+
+            while (auto entry = readdir(dir))
+            {
+                std::string name = entry->d_name;
+                if (name == "." || name == "..")
+                    continue;
+                auto path = relative.empty() ? name : relative + '/' + name;
+
+                //Not every file system fills in the type
+                bool directory = entry->d_type == DT_DIR;
+                if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK)
+                {
+                    struct stat info;
+                    directory = stat((root + '/' + path).c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+                }
+
+                if (directory)
+                    listFiles(root, path, files);
+                else if (isROMFile(name))
+                    files.push_back(path);
+            }
+            closedir(dir);
+            return true;
+#else
+            (void)root;
+            (void)relative;
+            (void)files;
+            LOG(Error) << "Scanning directories isn't supported on this platform" << std::endl;
+            return false;
+#endif
+        }
+
+        void indexFile(const std::string& path, ROMIndex::Entry& entry, std::vector<Byte>& buffer)
+        {
+            entry = ROMIndex::Entry();
+
+            MappedFile file;
+            const Byte* data = nullptr;
+            std::size_t size = 0;
+            if (file.open(path))
+            {
+                data = file.data();
+                size = file.size();
+            }
+            else
+            {
+                std::ifstream stream (path, std::ios_base::binary | std::ios_base::ate);
+                if (!stream)
+                    return;
+                buffer.resize(stream.tellg());
+                stream.seekg(0);
+                if (!stream.read(reinterpret_cast<char*>(buffer.data()), buffer.size()))
+                    return;
+                data = buffer.data();
+                size = buffer.size();
+            }
+            entry.fileSize = size;
+
+            ROMHeader header;
+            if (!Cartridge::parseHeader(data, size, header))
+                return;
+
+            entry.mapper = header.mapper;
+            entry.prgBanks = header.prgBanks;
+            entry.chrBanks = header.chrBanks;
+            entry.nameTableMirroring = header.nameTableMirroring;
+            entry.region = header.region;
+            entry.flags = ROMIndex::Valid |
+                          (Cartridge::isSupported(header, size) ? ROMIndex::Supported : 0) |
+                          (header.nes2 ? ROMIndex::NES2 : 0) |
+                          (header.trainer ? ROMIndex::Trainer : 0) |
+                          (header.extendedRAM ? ROMIndex::ExtendedRAM : 0);
+
+            //Hashed as a loaded cartridge would be, as far as the file has the banks it claims
+            std::size_t offset = 0x10 + (header.trainer ? 0x200 : 0);
+            offset = std::min(offset, size);
+            auto prgSize = std::min<std::size_t>(0x4000 * header.prgBanks, size - offset);
+            auto chrSize = std::min<std::size_t>(0x2000 * header.chrBanks, size - offset - prgSize);
+            entry.hash = Cartridge::hash(ROMView(data + offset, prgSize), ROMView(data + offset + prgSize, chrSize),
+                                         header.mapper);
+        }
+    }
+
+    bool ROMIndex::build(const std::string& directory, const std::string& indexPath, unsigned threads, std::ostream* out)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::string> files;
+        if (!listFiles(directory, "", files))
+        {
+            LOG(Error) << "Could not read directory " << directory << std::endl;
+            return false;
+        }
+        std::sort(files.begin(), files.end());
+
+        //Files are handed out one at a time, they're big enough for that to cost nothing
+        std::vector<Entry> entries (files.size());
+        std::atomic<std::size_t> next (0);
+        std::atomic<std::uint64_t> bytes (0);
+        auto work = [&]()
+        {
+            //Unsupported images are expected here, not errors
+            Log quiet;
+            auto previous = Log::setCurrent(&quiet);
+            std::vector<Byte> buffer;
+            for (std::size_t i; (i = next++) < files.size();)
+            {
+                indexFile(directory + '/' + files[i], entries[i], buffer);
+                bytes += entries[i].fileSize;
+            }
+            Log::setCurrent(previous);
+        };
+
+        if (threads == 0)
+            threads = std::max(std::thread::hardware_concurrency(), 1u);
+        std::vector<std::thread> pool;
+        for (unsigned i = 1; i < threads; ++i)
+            pool.emplace_back(work);
+        work();
+        for (auto& thread : pool)
+            thread.join();
+
+        std::vector<Byte> paths;
+        for (std::size_t i = 0; i < files.size(); ++i)
+        {
+            entries[i].pathOffset = paths.size();
+            paths.insert(paths.end(), files[i].begin(), files[i].end());
+            paths.push_back('\0');
+        }
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const Entry& a, const Entry& b) { return a.hash < b.hash; });
+
+        std::vector<Byte> index;
+        StateWriter writer (index);
+        writer.write(ROMIndexMagic);
+        writer.write(ROMIndexVersion);
+        writer.write(static_cast<std::uint32_t>(entries.size()));
+        writer.write(static_cast<std::uint32_t>(paths.size()));
+        writer.writeBytes(entries.data(), entries.size() * sizeof(Entry));
+        writer.write(paths);
+
+        std::ofstream file (indexPath, std::ios::binary);
+        if (!file || !file.write(reinterpret_cast<const char*>(index.data()), index.size()))
+        {
+            LOG(Error) << "Could not write the ROM index to " << indexPath << std::endl;
+            return false;
+        }
+
+        if (out)
+        {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            auto valid = std::count_if(entries.begin(), entries.end(), [](const Entry& e) { return e.flags & Valid; });
+            auto supported = std::count_if(entries.begin(), entries.end(), [](const Entry& e) { return e.flags & Supported; });
+            *out << std::fixed << std::setprecision(3)
+                 << "Images:    " << entries.size() << ", " << valid << " valid, " << supported << " supported\n"
+                 << "Read:      " << bytes / 1e6 << " MB in " << elapsed.count() << " s on " << threads << " threads, "
+                 << bytes / 1e6 / elapsed.count() << " MB/s\n"
+                 << "Index:     " << indexPath << ", " << index.size() << " bytes\n";
+        }
+        return true;
+    }
+
+    ROMIndex::ROMIndex() :
+        m_entries(nullptr),
+        m_size(0),
+        m_paths(nullptr)
+    {}
+
+    bool ROMIndex::load(const std::string& indexPath)
+    {
+        m_entries = nullptr;
+        m_size = 0;
+        m_paths = nullptr;
+        if (!m_file.open(indexPath))
+        {
+            LOG(Error) << "Could not map the ROM index " << indexPath << std::endl;
+            return false;
+        }
+
+        StateReader reader (m_file.data(), m_file.size());
+        if (reader.read<std::uint32_t>() != ROMIndexMagic || reader.read<std::uint32_t>() != ROMIndexVersion)
+        {
+            LOG(Error) << indexPath << " is not a ROM index of this version" << std::endl;
+            return false;
+        }
+        std::size_t count = reader.read<std::uint32_t>(), pathsSize = reader.read<std::uint32_t>();
+        if (!reader.good() || m_file.size() != ROMIndexHeaderSize + count * sizeof(Entry) + pathsSize ||
+            (pathsSize > 0 && m_file.data()[m_file.size() - 1] != '\0'))
+        {
+            LOG(Error) << "ROM index " << indexPath << " is damaged" << std::endl;
+            return false;
+        }
+
+        m_entries = reinterpret_cast<const Entry*>(m_file.data() + ROMIndexHeaderSize);
+        m_size = count;
+        m_paths = reinterpret_cast<const char*>(m_file.data() + ROMIndexHeaderSize + count * sizeof(Entry));
+        return true;
+    }
+
+    const ROMIndex::Entry* ROMIndex::find(std::uint64_t hash)
+    {
+        auto end = m_entries + m_size;
+        auto entry = std::lower_bound(m_entries, end, hash,
+                                      [](const Entry& e, std::uint64_t h) { return e.hash < h; });
+        return entry != end && entry->hash == hash ? entry : nullptr;
+    }
+}
@@ -0,0 +1,175 @@
+#include "RewindBuffer.h"
+#include <utility>
+
+namespace sn
+{
+    namespace
+    {
+        //Runs of at least this many unchanged bytes end a run of changed ones
+        const std::size_t MinUnchangedRun = 4;
+
+        void writeLength(std::vector<std::uint8_t>& out, std::size_t value)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back((value & 0x7f) | 0x80);
+                value >>= 7;
+            }
+            out.push_back(value);
+        }
+
+        std::size_t readLength(const std::vector<std::uint8_t>& in, std::size_t& pos)
+        {
+            std::size_t value = 0;
+            for (int shift = 0; ; shift += 7)
+            {
+                auto byte = in[pos++];
+                value |= static_cast<std::size_t>(byte & 0x7f) << shift;
+                if (!(byte & 0x80))
+                    return value;
+            }
+        }
+    }
+
+    RewindBuffer::RewindBuffer(std::size_t memoryLimit, int keyframeInterval) :
+        m_lastKeyframe(0),
+        m_memoryUsed(0),
+        m_memoryLimit(memoryLimit),
+        m_keyframeInterval(keyframeInterval)
+    {}
+
+    void RewindBuffer::setMemoryLimit(std::size_t bytes)
+    {
+        m_memoryLimit = bytes;
+        enforceLimit();
+    }
+
+    void RewindBuffer::setKeyframeInterval(int frames)
+    {
+        m_keyframeInterval = frames > 0 ? frames : 1;
+    }
+
+    void RewindBuffer::push(const std::vector<std::uint8_t>& state)
+    {
+        Entry entry;
+        entry.keyframe = m_entries.empty() ||
+                         m_entries.size() - m_lastKeyframe >= static_cast<std::size_t>(m_keyframeInterval) ||
+                         m_entries[m_lastKeyframe].data.size() != state.size();
+        if (entry.keyframe)
+        {
+            entry.data = state;
+            m_lastKeyframe = m_entries.size();
+        }
+        else
+        {
+            encodeDelta(m_entries[m_lastKeyframe].data, state);
+            entry.data.assign(m_scratch.begin(), m_scratch.end());
+        }
+
+        m_memoryUsed += entry.data.size() + sizeof(Entry);
+        m_entries.push_back(std::move(entry));
+        enforceLimit();
+    }
+
+    bool RewindBuffer::get(std::size_t age, std::vector<std::uint8_t>& state)
+    {
+        if (age >= m_entries.size())
+            return false;
+
+        auto index = m_entries.size() - 1 - age, keyframe = index;
+        while (!m_entries[keyframe].keyframe)
+            --keyframe;
+
+        state = m_entries[keyframe].data;
+        if (keyframe != index)
+            decodeDelta(m_entries[index].data, state);
+        return true;
+    }
+
+    void RewindBuffer::drop(std::size_t count)
+    {
+        for (; count > 0 && !m_entries.empty(); --count)
+        {
+            m_memoryUsed -= m_entries.back().data.size() + sizeof(Entry);
+            m_entries.pop_back();
+        }
+
+        m_lastKeyframe = 0;
+        for (auto i = m_entries.size(); i-- > 0;)
+        {
+            if (m_entries[i].keyframe)
+            {
+                m_lastKeyframe = i;
+                break;
+            }
+        }
+    }
+
+    void RewindBuffer::clear()
+    {
+        m_entries.clear();
+        m_lastKeyframe = 0;
+        m_memoryUsed = 0;
+    }
+
+    void RewindBuffer::enforceLimit()
+    {
+        while (m_memoryUsed > m_memoryLimit)
+        {
+            //Deltas can't outlive their keyframe, the whole group goes
+            std::size_t next = 1;
+            while (next < m_entries.size() && !m_entries[next].keyframe)
+                ++next;
+            if (next >= m_entries.size())
+                break;
+
+            for (std::size_t i = 0; i < next; ++i)
+            {
+                m_memoryUsed -= m_entries.front().data.size() + sizeof(Entry);
+                m_entries.pop_front();
+            }
+            m_lastKeyframe -= next;
+        }
+    }
+
+    void RewindBuffer::encodeDelta(const std::vector<std::uint8_t>& keyframe, const std::vector<std::uint8_t>& state)
+    {
+        //Pairs of (unchanged bytes to skip, changed bytes following) lengths, each pair followed by the changed bytes XORed
+        m_scratch.clear();
+        std::size_t i = 0, n = state.size();
+        while (i < n)
+        {
+            auto skipStart = i;
+            while (i < n && state[i] == keyframe[i])
+                ++i;
+            if (i == n)
+                break;
+
+            auto changedStart = i;
+            std::size_t unchanged = 0;
+            while (i < n && unchanged < MinUnchangedRun)
+            {
+                unchanged = state[i] == keyframe[i] ? unchanged + 1 : 0;
+                ++i;
+            }
+            i -= unchanged;
+
+            writeLength(m_scratch, changedStart - skipStart);
+            writeLength(m_scratch, i - changedStart);
+            for (auto j = changedStart; j < i; ++j)
+                m_scratch.push_back(state[j] ^ keyframe[j]);
+        }
+    }
+
+    void RewindBuffer::decodeDelta(const std::vector<std::uint8_t>& delta, std::vector<std::uint8_t>& state)
+    {
+        std::size_t pos = 0, i = 0;
+        while (pos < delta.size())
+        {
+            i += readLength(delta, pos);
+            auto changed = readLength(delta, pos);
+            for (std::size_t j = 0; j < changed; ++j)
+                state[i++] ^= delta[pos++];
+        }
+    }
+}
@@ -0,0 +1,166 @@
+#include "Runner.h"
+#include <algorithm>
+#include <iomanip>
+
+namespace sn
+{
+    namespace
+    {
+        //NTSC frames per second
+        const double NESFrameRate = 60.0988;
+    }
+
+    Runner::Runner(unsigned threads) :
+        m_job(nullptr),
+        m_run(0),
+        m_remaining(0),
+        m_stop(false)
+    {
+        if (threads == 0)
+            threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+        for (unsigned i = 0; i < threads; ++i)
+            m_workers.emplace_back(new Worker);
+        for (unsigned i = 0; i < threads; ++i)
+            m_workers[i]->thread = std::thread(&Runner::work, this, i);
+    }
+
+    Runner::~Runner()
+    {
+        {
+            std::lock_guard<std::mutex> lock (m_mutex);
+            m_stop = true;
+        }
+        m_runStarted.notify_all();
+        for (auto& worker : m_workers)
+            worker->thread.join();
+    }
+
+    bool Runner::addInstance(const std::string& romPath, std::ostream* log, bool mapFile)
+    {
+        std::unique_ptr<Instance> instance (new Instance);
+        if (log)
+        {
+            //There's no CPU trace stream per instance
+            instance->log.setLogStream(*log);
+            instance->log.setLevel(std::min(Log::get().getLevel(), InfoVerbose));
+        }
+
+        auto previous = Log::setCurrent(&instance->log);
+        bool loaded = instance->console.loadROM(romPath, mapFile);
+        Log::setCurrent(previous);
+
+        if (loaded)
+            m_instances.push_back(std::move(instance));
+        return loaded;
+    }
+
+    void Runner::runFrames(int frames)
+    {
+        forEach([this, frames](std::size_t instance, Console& console)
+        {
+            for (int frame = 0; frame < frames; ++frame)
+            {
+                if (m_input)
+                {
+                    auto buttons = m_input(instance, console.getFrameCount());
+                    console.setButtons(0, buttons[0]);
+                    console.setButtons(1, buttons[1]);
+                }
+                console.runFrame();
+            }
+        });
+    }
+
+    void Runner::forEach(const Job& job)
+    {
+        std::unique_lock<std::mutex> lock (m_mutex);
+        m_job = &job;
+        m_remaining = m_instances.size();
+        for (std::size_t i = 0; i < m_workers.size(); ++i)
+        {
+            auto& worker = *m_workers[i];
+            std::lock_guard<std::mutex> queueLock (worker.mutex);
+            worker.queue.clear();
+            worker.front = 0;
+            for (auto instance = i; instance < m_instances.size(); instance += m_workers.size())
+                worker.queue.push_back(instance);
+        }
+        ++m_run;
+        m_runStarted.notify_all();
+
+        m_runDone.wait(lock, [&]{ return m_remaining == 0; });
+    }
+
+    void Runner::benchmark(int frames, std::ostream& out)
+    {
+        auto start = Profiler::Clock::now();
+        runFrames(frames);
+        std::chrono::duration<double> elapsed = Profiler::Clock::now() - start;
+
+        auto seconds = elapsed.count();
+        auto total = static_cast<std::uint64_t>(frames) * m_instances.size();
+        out << std::fixed << std::setprecision(3)
+            << "Instances:  " << m_instances.size() << " on " << m_workers.size() << " threads\n"
+            << "Frames:     " << total << " in " << seconds << " s, " << total / seconds << " frames/s\n"
+            << "Speed:      " << total / seconds / NESFrameRate << "x real NES in total, "
+            << frames / seconds / NESFrameRate << "x per instance\n";
+    }
+
+    void Runner::work(std::size_t worker)
+    {
+        std::uint64_t run = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock (m_mutex);
+                m_runStarted.wait(lock, [&]{ return m_stop || m_run != run; });
+                if (m_stop)
+                    return;
+                run = m_run;
+            }
+
+            std::size_t instance;
+            while (takeInstance(worker, instance))
+            {
+                runInstance(instance);
+
+                std::lock_guard<std::mutex> lock (m_mutex);
+                if (--m_remaining == 0)
+                    m_runDone.notify_all();
+            }
+        }
+    }
+
+    bool Runner::takeInstance(std::size_t worker, std::size_t& instance)
+    {
+        for (std::size_t i = 0; i < m_workers.size(); ++i)
+        {
+            auto& victim = *m_workers[(worker + i) % m_workers.size()];
+            std::lock_guard<std::mutex> lock (victim.mutex);
+            if (victim.front == victim.queue.size())
+                continue;
+
+            //Its own from the front, the others' from the back where their owners get to last
+            if (i == 0)
+            {
+                instance = victim.queue[victim.front++];
+            }
+            else
+            {
+                instance = victim.queue.back();
+                victim.queue.pop_back();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void Runner::runInstance(std::size_t index)
+    {
+        auto& instance = *m_instances[index];
+        auto previous = Log::setCurrent(&instance.log);
+        (*m_job)(index, instance.console);
+        Log::setCurrent(previous);
+    }
+}
@@ -0,0 +1,33 @@
+#include "Scheduler.h"
+#include <algorithm>
+
+namespace sn
+{
+    Scheduler::Scheduler()
+    {
+        clear();
+    }
+
+    void Scheduler::schedule(Event event, Timestamp time)
+    {
+        m_times[event] = time;
+        updateNextEvent();
+    }
+
+    void Scheduler::cancel(Event event)
+    {
+        m_times[event] = NeverScheduled;
+        updateNextEvent();
+    }
+
+    void Scheduler::clear()
+    {
+        m_times.fill(NeverScheduled);
+        m_nextEventTime = NeverScheduled;
+    }
+
+    void Scheduler::updateNextEvent()
+    {
+        m_nextEventTime = *std::min_element(m_times.begin(), m_times.end());
+    }
+}
@@ -0,0 +1,48 @@
+#include "SharedState.h"
+#include <algorithm>
+#include <cstring>
+
+namespace sn
+{
+    const std::size_t SharedState::PageSize;
+
+    void SharedState::assign(const std::vector<std::uint8_t>& state, const SharedState* base)
+    {
+        std::shared_ptr<Table> table (new Table);
+        auto pageCount = (state.size() + PageSize - 1) / PageSize;
+        table->pages.reserve(pageCount);
+        table->size = state.size();
+        table->ownMemory = sizeof(Table) + pageCount * sizeof(table->pages[0]);
+
+        //Pages are shared by position, which stays the same for states of the same ROM
+        const Table* baseTable = base ? base->m_table.get() : nullptr;
+        for (std::size_t i = 0; i < pageCount; ++i)
+        {
+            auto offset = i * PageSize;
+            auto length = std::min(PageSize, state.size() - offset);
+
+            if (baseTable && i < baseTable->pages.size() && offset + length <= baseTable->size &&
+                std::memcmp(baseTable->pages[i]->data(), &state[offset], length) == 0)
+            {
+                table->pages.push_back(baseTable->pages[i]);
+                continue;
+            }
+
+            auto page = std::make_shared<Page>();
+            std::memcpy(page->data(), &state[offset], length);
+            table->pages.push_back(page);
+            table->ownMemory += sizeof(Page);
+        }
+        m_table = table;
+    }
+
+    void SharedState::copyTo(std::vector<std::uint8_t>& state) const
+    {
+        state.resize(size());
+        for (std::size_t i = 0; m_table && i < m_table->pages.size(); ++i)
+        {
+            auto offset = i * PageSize;
+            std::memcpy(&state[offset], m_table->pages[i]->data(), std::min(PageSize, state.size() - offset));
+        }
+    }
+}
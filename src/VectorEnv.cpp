@@ -0,0 +1,105 @@
+#include "VectorEnv.h"
+#include "Log.h"
+#include <algorithm>
+
+namespace sn
+{
+    const std::size_t VectorEnv::FrameSize;
+    const std::size_t VectorEnv::RAMSize;
+
+    VectorEnv::VectorEnv(unsigned threads) :
+        m_runner(threads),
+        m_frameSkip(1),
+        m_actions(nullptr),
+        m_out()
+    {
+        //Built once, so that stepping doesn't allocate
+        m_resetJob = [this](std::size_t instance, Console& console)
+        {
+            resetInstance(instance, console);
+        };
+        m_stepJob = [this](std::size_t instance, Console& console)
+        {
+            if (m_done[instance])
+            {
+                resetInstance(instance, console);
+                return;
+            }
+
+            console.setButtons(0, m_actions[instance]);
+            for (int frame = 1; frame <= m_frameSkip; ++frame)
+            {
+                console.setVideoEnabled(m_out.frames && frame == m_frameSkip);
+                console.runFrame();
+            }
+            m_done[instance] = m_doneCondition && m_doneCondition(instance, console);
+            writeObservation(instance, console.getFrame(), console.getRAM());
+        };
+    }
+
+    bool VectorEnv::create(const std::string& romPath, std::size_t instances)
+    {
+        //Only the first one logs, the rest would repeat it
+        for (std::size_t i = 0; i < instances; ++i)
+        {
+            auto log = i == 0 && Log::get().getLevel() != None ? &Log::get().getStream() : nullptr;
+            if (!m_runner.addInstance(romPath, log))
+                return false;
+        }
+
+        m_done.assign(size(), 0);
+        if (size() > 0)
+            setResetState(0);
+        return true;
+    }
+
+    void VectorEnv::setFrameSkip(int frames)
+    {
+        m_frameSkip = frames > 0 ? frames : 1;
+    }
+
+    void VectorEnv::setResetState(std::size_t instance)
+    {
+        //The picture isn't part of the state
+        getConsole(instance).saveState(m_resetState);
+        m_resetFrame = getConsole(instance).getFrame();
+    }
+
+    void VectorEnv::reset(const Observations& out)
+    {
+        m_out = out;
+        m_runner.forEach(m_resetJob);
+    }
+
+    void VectorEnv::step(const Byte* actions, const Observations& out)
+    {
+        m_actions = actions;
+        m_out = out;
+        m_runner.forEach(m_stepJob);
+    }
+
+    void VectorEnv::resetInstance(std::size_t instance, Console& console)
+    {
+        if (!console.loadState(m_resetState))
+        {
+            //Left as it was and still done, so the next step tries again
+            LOG(Error) << "Could not reset instance " << instance << std::endl;
+            m_done[instance] = 1;
+            writeObservation(instance, console.getFrame(), console.getRAM());
+            return;
+        }
+        m_done[instance] = 0;
+        writeObservation(instance, m_resetFrame, console.getRAM());
+    }
+
+    void VectorEnv::writeObservation(std::size_t instance, const std::vector<std::uint32_t>& frame,
+                                     const std::vector<Byte>& ram)
+    {
+        if (m_out.frames)
+            std::copy(frame.begin(), frame.end(), m_out.frames + instance * FrameSize);
+        if (m_out.ram)
+            std::copy(ram.begin(), ram.end(), m_out.ram + instance * RAMSize);
+        if (m_out.done)
+            m_out.done[instance] = m_done[instance];
+    }
+}
@@ -4,79 +4,44 @@ namespace sn
 {
     void VirtualScreen::create(unsigned int w, unsigned int h, float pixel_size, sf::Color color)
     {
-        m_vertices.resize(w * h * 6);
         m_screenSize = {w, h};
-        m_vertices.setPrimitiveType(sf::Triangles);
         m_pixelSize = pixel_size;
-        for (std::size_t x = 0; x < w; ++x)
-        {
-            for (std::size_t y = 0; y < h; ++y)
-            {
-                auto index = (x * m_screenSize.y + y) * 6;
-                sf::Vector2f coord2d (x * m_pixelSize, y * m_pixelSize);
-
-                //Triangle-1
-                //top-left
-                m_vertices[index].position = coord2d;
-                m_vertices[index].color    = color;
-
-                //top-right
-                m_vertices[index + 1].position = coord2d + sf::Vector2f{m_pixelSize, 0};
-                m_vertices[index + 1].color = color;
-
-                //bottom-right
-                m_vertices[index + 2].position = coord2d + sf::Vector2f{m_pixelSize, m_pixelSize};
-                m_vertices[index + 2].color = color;
 
-                //Triangle-2
-                //bottom-right
-                m_vertices[index + 3].position = coord2d + sf::Vector2f{m_pixelSize, m_pixelSize};
-                m_vertices[index + 3].color = color;
+        m_pixels.resize(w * h * 4);
+        for (std::size_t i = 0; i < m_pixels.size(); i += 4)
+        {
+            m_pixels[i]     = color.r;
+            m_pixels[i + 1] = color.g;
+            m_pixels[i + 2] = color.b;
+            m_pixels[i + 3] = color.a;
+        }
 
-                //bottom-left
-                m_vertices[index + 4].position = coord2d + sf::Vector2f{0, m_pixelSize};
-                m_vertices[index + 4].color = color;
+        m_texture.create(w, h);
+        //Scaled up, every virtual pixel stays a sharp square
+        m_texture.setSmooth(false);
+        m_texture.update(m_pixels.data());
 
-                //top-left
-                m_vertices[index + 5].position = coord2d;
-                m_vertices[index + 5].color    = color;
-            }
-        }
+        m_sprite.setTexture(m_texture, true);
+        m_sprite.setScale(m_pixelSize, m_pixelSize);
     }
 
-    void VirtualScreen::setPixel(std::size_t x, std::size_t y, sf::Color color)
+    void VirtualScreen::setPixels(const std::uint32_t* pixels)
     {
-        auto index = (x * m_screenSize.y + y) * 6;
-        if (index >= m_vertices.getVertexCount())
-            return;
-
-        sf::Vector2f coord2d (x * m_pixelSize, y * m_pixelSize);
-
-        //Triangle-1
-        //top-left
-        m_vertices[index].color    = color;
-
-        //top-right
-        m_vertices[index + 1].color = color;
-
-        //bottom-right
-        m_vertices[index + 2].color = color;
-
-        //Triangle-2
-        //bottom-right
-        m_vertices[index + 3].color = color;
-
-        //bottom-left
-        m_vertices[index + 4].color = color;
-
-        //top-left
-        m_vertices[index + 5].color    = color;
+        auto out = m_pixels.data();
+        for (std::size_t i = 0; i < m_pixels.size() / 4; ++i, out += 4)
+        {
+            out[0] = pixels[i] >> 24;
+            out[1] = pixels[i] >> 16;
+            out[2] = pixels[i] >> 8;
+            out[3] = pixels[i];
+        }
+        m_texture.update(m_pixels.data());
     }
 
     void VirtualScreen::draw(sf::RenderTarget& target, sf::RenderStates states) const
     {
-        target.draw(m_vertices, states);
+        target.draw(m_sprite, states);
     }
 
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,314 @@
+//Headless checks of the core against the ROMs in tests/roms, run by ctest:
+//  simplenes_check frames <rom> <hash>
+//      Runs the ROM with a fixed input and compares a hash of every frame (palette colors, emphasis,
+//      RGBA) and of the RAM after it to the given one
+//  simplenes_check states <rom> <movie file>
+//      Runs the ROM the same way, going through save states, SharedStates, rewinding and a movie saved
+//      to the given file and played back. Every frame has to come out as it did without them, and a
+//      damaged save state, one of another ROM or a damaged rewind snapshot has to leave the console as it
+//      was. The other ROM is a copy with one byte changed, saved next to the movie.
+#include "Console.h"
+#include "Movie.h"
+#include "SharedState.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const int Frames = 300;
+
+    //FNV-1a, 64 bits. Values are added lowest byte first, so it's the same on any machine.
+    class Hash
+    {
+        public:
+            Hash() : m_value(14695981039346656037ull) {}
+            void add(std::uint8_t byte) { m_value = (m_value ^ byte) * 1099511628211ull; }
+            void add(std::uint32_t value)
+            {
+                for (int i = 0; i < 4; ++i)
+                    add(std::uint8_t(value >> (8 * i)));
+            }
+            void add(std::uint64_t value)
+            {
+                add(std::uint32_t(value));
+                add(std::uint32_t(value >> 32));
+            }
+            template <typename T>
+            void add(const std::vector<T>& values)
+            {
+                for (auto value : values)
+                    add(value);
+            }
+            std::uint64_t get() const { return m_value; }
+        private:
+            std::uint64_t m_value;
+    };
+
+    //Buttons of both controllers held during the given frame, the same on every run
+    void setInput(sn::Console& console, int frame)
+    {
+        console.setButtons(0, (frame * 37 + (frame >> 3)) & 0xff);
+        console.setButtons(1, (frame * 11) & 0xff);
+    }
+
+    //What the console shows and holds after a frame
+    std::uint64_t hashFrame(sn::Console& console)
+    {
+        Hash hash;
+        hash.add(console.getPaletteFrame());
+        hash.add(console.getEmphasis());
+        hash.add(console.getFrame());
+        hash.add(console.getRAM());
+        return hash.get();
+    }
+
+    bool load(sn::Console& console, const std::string& rom)
+    {
+        if (console.loadROM(rom))
+            return true;
+        std::cerr << "Can't load " << rom << std::endl;
+        return false;
+    }
+
+    //Runs frames [from, to) with the fixed input, false if one doesn't hash to the expected one
+    bool runFrames(sn::Console& console, int from, int to, const std::vector<std::uint64_t>& expected,
+                   const std::string& what)
+    {
+        for (int frame = from; frame < to; ++frame)
+        {
+            setInput(console, frame);
+            console.runFrame();
+            if (hashFrame(console) != expected[frame])
+            {
+                std::cerr << what << ": frame " << frame << " differs" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool fail(const std::string& what)
+    {
+        std::cerr << what << std::endl;
+        return false;
+    }
+
+    int checkStates(const std::string& rom, const std::string& moviePath)
+    {
+        const int Middle = Frames / 2;
+        //More than a keyframe interval of the rewind buffer
+        const int Rewound = 100;
+
+        std::vector<std::uint64_t> expected;
+        {
+            sn::Console console;
+            if (!load(console, rom))
+                return EXIT_FAILURE;
+            for (int frame = 0; frame < Frames; ++frame)
+            {
+                setInput(console, frame);
+                console.runFrame();
+                expected.push_back(hashFrame(console));
+            }
+        }
+
+        auto saveLoad = [&]()
+        {
+            sn::Console console, other;
+            std::vector<sn::Byte> state;
+            load(console, rom);
+            load(other, rom);
+            if (!runFrames(console, 0, Middle, expected, "before saving"))
+                return false;
+            console.saveState(state);
+            if (!runFrames(console, Middle, Frames, expected, "after saving"))
+                return false;
+            if (!console.loadState(state) || !runFrames(console, Middle, Frames, expected, "loaded"))
+                return fail("save state loaded into the same console");
+            if (!other.loadState(state) || !runFrames(other, Middle, Frames, expected, "loaded"))
+                return fail("save state loaded into a new console");
+            return true;
+        };
+
+        auto damaged = [&]()
+        {
+            sn::Console console;
+            std::vector<sn::Byte> state, before, after;
+            load(console, rom);
+            runFrames(console, 0, Middle, expected, "before saving");
+            console.saveState(state);
+            runFrames(console, Middle, Middle + 50, expected, "after saving");
+            console.saveState(before);
+            //Cut short with the size in the header changed to match, so only the rest shows the damage
+            for (auto size : {state.size() / 4, state.size() / 2, state.size() - 1})
+            {
+                std::vector<sn::Byte> cut (state.begin(), state.begin() + size);
+                auto size32 = static_cast<std::uint32_t>(size);
+                std::memcpy(&cut[2 * sizeof(std::uint32_t)], &size32, sizeof(size32));
+                if (console.loadState(cut))
+                    return fail("damaged save state loaded");
+                console.saveState(after);
+                if (after != before)
+                    return fail("damaged save state changed the console");
+            }
+            return runFrames(console, Middle + 50, Frames, expected, "after a damaged save state");
+        };
+
+        auto otherROM = [&]()
+        {
+            //Same mapper and sizes, only the first byte of PRG ROM (after the 16 byte header) differs
+            std::string otherPath = moviePath + ".nes";
+            {
+                std::ifstream in (rom, std::ios::binary);
+                std::vector<char> image ((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+                if (image.size() <= 16)
+                    return fail("can't read " + rom);
+                image[16] ^= 1;
+                std::ofstream out (otherPath, std::ios::binary);
+                if (!out.write(image.data(), image.size()))
+                    return fail("can't write " + otherPath);
+            }
+
+            sn::Console console, other;
+            std::vector<sn::Byte> state, before, after;
+            load(console, rom);
+            bool loaded = load(other, otherPath);
+            std::remove(otherPath.c_str());
+            if (!loaded)
+                return false;
+            runFrames(console, 0, Middle, expected, "before saving");
+            console.saveState(before);
+            other.runFrame();
+            other.saveState(state);
+            if (console.loadState(state))
+                return fail("save state of another ROM loaded");
+            console.saveState(after);
+            if (after != before)
+                return fail("save state of another ROM changed the console");
+            return runFrames(console, Middle, Frames, expected, "after a save state of another ROM");
+        };
+
+        auto shared = [&]()
+        {
+            sn::Console console, other;
+            sn::SharedState base, next;
+            load(console, rom);
+            load(other, rom);
+            runFrames(console, 0, Middle, expected, "before saving");
+            console.saveState(base);
+            runFrames(console, Middle, Middle + 1, expected, "between saves");
+            console.saveState(next, &base);
+            if (!other.loadState(next) || !runFrames(other, Middle + 1, Frames, expected, "loaded"))
+                return fail("SharedState saved after another");
+            if (!other.loadState(base) || !runFrames(other, Middle, Frames, expected, "loaded"))
+                return fail("SharedState");
+            return true;
+        };
+
+        auto rewind = [&]()
+        {
+            sn::Console console;
+            load(console, rom);
+            console.setRewindEnabled(true);
+            if (!runFrames(console, 0, Frames, expected, "recording for rewind"))
+                return false;
+            //Each one goes back to the end of the frame before, drawn again
+            for (int frame = Frames - 2; frame >= Frames - 1 - Rewound; --frame)
+            {
+                if (!console.rewindFrame() || hashFrame(console) != expected[frame])
+                    return fail("rewinding to frame " + std::to_string(frame));
+            }
+            if (!runFrames(console, Frames - Rewound, Frames, expected, "after rewinding"))
+                return false;
+
+            //With the snapshot before the newest damaged, neither the console nor the history changes
+            auto& history = console.getRewindBuffer();
+            std::vector<sn::Byte> newest, before, after;
+            history.get(0, newest);
+            history.drop(1);
+            history.push(std::vector<sn::Byte>(newest.size()));
+            history.push(newest);
+            auto size = history.size();
+            console.saveState(before);
+            if (console.rewindFrame())
+                return fail("rewound to a damaged snapshot");
+            console.saveState(after);
+            if (after != before || history.size() != size)
+                return fail("rewinding to a damaged snapshot changed the console or the history");
+            return true;
+        };
+
+        auto movie = [&]()
+        {
+            sn::Console console, player;
+            sn::Movie recorded, played;
+            load(console, rom);
+            load(player, rom);
+            runFrames(console, 0, Middle, expected, "before recording");
+            console.recordMovie(recorded);
+            runFrames(console, Middle, Frames, expected, "recording");
+            console.stopMovie();
+            if (!recorded.saveToFile(moviePath) || !played.loadFromFile(moviePath))
+                return fail("saving and loading the movie " + moviePath);
+            std::remove(moviePath.c_str());
+            if (played.getLength() != std::size_t(Frames - Middle))
+                return fail("movie of " + std::to_string(played.getLength()) + " frames");
+            //The movie's input replaces the one set while it plays
+            if (!player.playMovie(played) || !runFrames(player, Middle, Frames, expected, "playing"))
+                return fail("movie played back");
+            return true;
+        };
+
+        bool ok = saveLoad();
+        ok = damaged() && ok;
+        ok = otherROM() && ok;
+        ok = shared() && ok;
+        ok = rewind() && ok;
+        ok = movie() && ok;
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    int checkFrames(const std::string& rom, std::uint64_t expected)
+    {
+        sn::Console console;
+        if (!load(console, rom))
+            return EXIT_FAILURE;
+
+        Hash hash;
+        for (int frame = 0; frame < Frames; ++frame)
+        {
+            setInput(console, frame);
+            console.runFrame();
+            hash.add(hashFrame(console));
+        }
+
+        if (hash.get() != expected)
+        {
+            std::cerr << rom << ": hash of " << Frames << " frames is " << std::hex << hash.get()
+                      << ", expected " << expected << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "frames" && argc == 4)
+        return checkFrames(argv[2], std::strtoull(argv[3], nullptr, 16));
+    if (mode == "states" && argc == 4)
+        return checkStates(argv[2], argv[3]);
+
+    std::cerr << "Usage: simplenes_check frames <rom> <hash>\n"
+              << "       simplenes_check states <rom> <movie file>" << std::endl;
+    return EXIT_FAILURE;
+}
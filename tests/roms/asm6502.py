@@ -0,0 +1,95 @@
+#A small 6502 assembler, just enough for make_roms.py
+import re
+OPS = {}
+def reg(m, modes):
+    for mode, code in modes.items(): OPS[(m, mode)] = code
+# modes: imp acc imm zp zpx zpy abs abx aby ind izx izy rel
+reg('ADC', dict(imm=0x69, zp=0x65, zpx=0x75, abs=0x6D, abx=0x7D, aby=0x79, izx=0x61, izy=0x71))
+reg('AND', dict(imm=0x29, zp=0x25, zpx=0x35, abs=0x2D, abx=0x3D, aby=0x39, izx=0x21, izy=0x31))
+reg('ASL', dict(acc=0x0A, zp=0x06, zpx=0x16, abs=0x0E, abx=0x1E))
+reg('BIT', dict(zp=0x24, abs=0x2C))
+for m, c in dict(BPL=0x10, BMI=0x30, BVC=0x50, BVS=0x70, BCC=0x90, BCS=0xB0, BNE=0xD0, BEQ=0xF0).items(): reg(m, dict(rel=c))
+reg('BRK', dict(imp=0x00))
+reg('CMP', dict(imm=0xC9, zp=0xC5, zpx=0xD5, abs=0xCD, abx=0xDD, aby=0xD9, izx=0xC1, izy=0xD1))
+reg('CPX', dict(imm=0xE0, zp=0xE4, abs=0xEC))
+reg('CPY', dict(imm=0xC0, zp=0xC4, abs=0xCC))
+reg('DEC', dict(zp=0xC6, zpx=0xD6, abs=0xCE, abx=0xDE))
+reg('EOR', dict(imm=0x49, zp=0x45, zpx=0x55, abs=0x4D, abx=0x5D, aby=0x59, izx=0x41, izy=0x51))
+for m, c in dict(CLC=0x18, SEC=0x38, CLI=0x58, SEI=0x78, CLV=0xB8, CLD=0xD8, SED=0xF8, DEX=0xCA, DEY=0x88, INX=0xE8, INY=0xC8, NOP=0xEA,
+                 PHA=0x48, PHP=0x08, PLA=0x68, PLP=0x28, RTI=0x40, RTS=0x60, TAX=0xAA, TAY=0xA8, TSX=0xBA, TXA=0x8A, TXS=0x9A, TYA=0x98).items(): reg(m, dict(imp=c))
+reg('INC', dict(zp=0xE6, zpx=0xF6, abs=0xEE, abx=0xFE))
+reg('JMP', dict(abs=0x4C, ind=0x6C))
+reg('JSR', dict(abs=0x20))
+reg('LDA', dict(imm=0xA9, zp=0xA5, zpx=0xB5, abs=0xAD, abx=0xBD, aby=0xB9, izx=0xA1, izy=0xB1))
+reg('LDX', dict(imm=0xA2, zp=0xA6, zpy=0xB6, abs=0xAE, aby=0xBE))
+reg('LDY', dict(imm=0xA0, zp=0xA4, zpx=0xB4, abs=0xAC, abx=0xBC))
+reg('LSR', dict(acc=0x4A, zp=0x46, zpx=0x56, abs=0x4E, abx=0x5E))
+reg('ORA', dict(imm=0x09, zp=0x05, zpx=0x15, abs=0x0D, abx=0x1D, aby=0x19, izx=0x01, izy=0x11))
+reg('ROL', dict(acc=0x2A, zp=0x26, zpx=0x36, abs=0x2E, abx=0x3E))
+reg('ROR', dict(acc=0x6A, zp=0x66, zpx=0x76, abs=0x6E, abx=0x7E))
+reg('SBC', dict(imm=0xE9, zp=0xE5, zpx=0xF5, abs=0xED, abx=0xFD, aby=0xF9, izx=0xE1, izy=0xF1))
+reg('STA', dict(zp=0x85, zpx=0x95, abs=0x8D, abx=0x9D, aby=0x99, izx=0x81, izy=0x91))
+reg('STX', dict(zp=0x86, zpy=0x96, abs=0x8E))
+reg('STY', dict(zp=0x84, zpx=0x94, abs=0x8C))
+SIZE = dict(imp=1, acc=1, imm=2, zp=2, zpx=2, zpy=2, abs=3, abx=3, aby=3, ind=3, izx=2, izy=2, rel=2)
+
+class Asm:
+    def __init__(self, org):
+        self.org = org; self.items = []; self.labels = {}; self.pc = org
+    def label(self, name): self.labels[name] = self.pc
+    def db(self, *bs):
+        for b in bs: self.items.append(('db', b)); self.pc += 1
+    def __call__(self, line):
+        for part in line.split(';'):
+            part = part.strip()
+            if not part: continue
+            mm = re.match(r'^(\w+):\s*(.*)$', part)
+            if mm:
+                self.label(mm.group(1)); part = mm.group(2)
+                if not part: continue
+            m, _, opnd = part.partition(' ')
+            self.ins(m.upper(), opnd.strip())
+    def val(self, s):
+        s = s.strip()
+        if s.startswith('<'): return ('lo', s[1:])
+        if s.startswith('>'): return ('hi', s[1:])
+        if s.startswith('$'): return int(s[1:], 16)
+        if re.fullmatch(r'\d+', s): return int(s)
+        return s
+    def ins(self, m, o):
+        if m in ('BPL','BMI','BVC','BVS','BCC','BCS','BNE','BEQ'): mode, v = 'rel', self.val(o)
+        elif o == '': mode, v = ('imp' if (m, 'imp') in OPS else 'acc'), None
+        elif o == 'A': mode, v = 'acc', None
+        elif o.startswith('#'): mode, v = 'imm', self.val(o[1:])
+        elif o.startswith('(') and o.upper().endswith(',X)'): mode, v = 'izx', self.val(o[1:-3])
+        elif o.startswith('(') and o.upper().endswith('),Y'): mode, v = 'izy', self.val(o[1:-3])
+        elif o.startswith('('): mode, v = 'ind', self.val(o[1:-1])
+        else:
+            idx = None
+            if o.upper().endswith(',X'): idx, o = 'x', o[:-2]
+            elif o.upper().endswith(',Y'): idx, o = 'y', o[:-2]
+            v = self.val(o)
+            zp = isinstance(v, int) and v < 0x100
+            mode = {None: 'zp' if zp else 'abs', 'x': 'zpx' if zp else 'abx', 'y': 'zpy' if zp else 'aby'}[idx]
+            if (m, mode) not in OPS and mode in ('zp', 'zpx', 'zpy'):
+                mode = {'zp': 'abs', 'zpx': 'abx', 'zpy': 'aby'}[mode]
+        code = OPS[(m, mode)]
+        self.items.append(('ins', code, mode, v, self.pc)); self.pc += SIZE[mode]
+    def resolve(self, v):
+        if isinstance(v, tuple):
+            x = self.resolve(v[1]); return x & 0xff if v[0] == 'lo' else x >> 8
+        if isinstance(v, str): return self.labels[v]
+        return v
+    def assemble(self):
+        out = bytearray()
+        for it in self.items:
+            if it[0] == 'db': out.append(self.resolve(it[1]) & 0xff); continue
+            _, code, mode, v, pc = it
+            out.append(code)
+            if SIZE[mode] == 1: continue
+            x = self.resolve(v)
+            if mode == 'rel':
+                off = x - (pc + 2); assert -128 <= off <= 127, (hex(pc), off); out.append(off & 0xff)
+            elif SIZE[mode] == 2: out.append(x & 0xff)
+            else: out += bytes([x & 0xff, x >> 8])
+        return bytes(out)
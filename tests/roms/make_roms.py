@@ -0,0 +1,125 @@
+#Generates the test ROMs next to this script: random but fixed programs, patterns and palettes that
+#exercise the CPU, NMI, OAM DMA, the controller, sprite 0 hits, mid-frame scrolling and
+# - nrom.nes: NROM (mapper 0)
+# - mmc3.nes: MMC3 (mapper 4) bank switching and its scanline IRQ
+# - chrram.nes: NROM with CHR RAM, rewritten mid-frame
+#The .nes files are committed, this is how they were made: python3 make_roms.py
+import os, random, sys
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from asm6502 import Asm
+
+def common_init(a):
+    a("SEI; CLD; LDX #$FF; TXS")
+    a("vw1: BIT $2002; BPL vw1; vw2: BIT $2002; BPL vw2")
+    # palette
+    a("LDA #$3F; STA $2006; LDA #$00; STA $2006; LDX #0")
+    a("pal: LDA paldata,X; STA $2007; INX; CPX #32; BNE pal")
+    # nametables 0x2000-0x27ff
+    a("LDA #$20; STA $2006; LDA #$00; STA $2006; LDY #8; LDX #0; LDA #7; STA $00")
+    a("nt: LDA $00; ASL A; BCC nt1; EOR #$1D; nt1: STA $00; STA $2007; INX; BNE nt; DEY; BNE nt")
+    # OAM table to $0200
+    a("LDX #0; oam: LDA oamdata,X; STA $0200,X; INX; BNE oam")
+    a("LDA #0; STA $10; STA $11; STA $12; STA $13")
+    a("LDA #$88; STA $2000; LDA #$1E; STA $2001; CLI")
+
+def work(a):
+    # CPU exercise touching many opcodes
+    a("LDA $12; CLC; ADC #$37; STA $12; SBC $13; ROR A; STA $13")
+    a("LDX #5; wk: LDA $20,X; EOR $12; ROL A; STA $20,X; LSR $21; ASL $22; INC $30,X; DEC $31; DEX; BPL wk")
+    a("LDY #3; LDA ($40),Y; ORA #1; AND #$7F; CMP #$40; BCS wk2; LDX $13; LDA $0200,X; STA $50; wk2:")
+    a("LDA #$20; STA $40; LDA #$00; STA $41; LDY $12; LDA ($40),Y; STA ($40),Y; BIT $12; PHP; PLP")
+    a("JSR sub; TSX; TXA; PHA; PLA; TAY; INY; DEY; STY $60; STX $61; CPX #$F0; CPY $60")
+
+def nmi(a, extra=""):
+    a("nmi: PHA; TXA; PHA; TYA; PHA")
+    a("LDA #$00; STA $2003; LDA #$02; STA $4014")
+    a("INC $0203; INC $0204; DEC $0208; INC $10; LDA $10; STA $2005; LDA $11; STA $2005")
+    a("LDA #1; STA $4016; LDA #0; STA $4016; LDX #8; rj: LDA $4016; LSR A; ROL $14; DEX; BNE rj")
+    a("LDA $2002; LDA #$23; STA $2006; LDA $10; STA $2006; LDA $2007; LDA $2007; STA $15")
+    a("LDA #$3F; STA $2006; LDA $10; AND #$1F; STA $2006; LDA $10; AND #$3F; STA $2007")
+    a(extra)
+    a("LDA #$88; STA $2000")
+    a("PLA; TAY; PLA; TAX; PLA; RTI")
+
+def data(a, rnd):
+    a.label('sub'); a("LDA $12; EOR #$55; STA $12; RTS")
+    a.label('paldata'); a.db(*[rnd.randrange(0x40) for _ in range(32)])
+    a.label('oamdata')
+    for i in range(64):
+        a.db(rnd.randrange(0, 0xE8) if i else 0x18, rnd.randrange(256), rnd.randrange(256), rnd.randrange(256) if i else 0x40)
+
+def header(prg16, chr8, mapper, mirror=1):
+    return bytes([0x4E, 0x45, 0x53, 0x1A, prg16, chr8, ((mapper & 0xF) << 4) | mirror, mapper & 0xF0, 0, 0, 0, 0, 0, 0, 0, 0])
+
+def nrom(path, seed=1):
+    rnd = random.Random(seed)
+    a = Asm(0x8000)
+    a.label('reset'); common_init(a)
+    a("main:")
+    # sprite zero split: wait for clear, then set, then rewrite scroll
+    a("s0a: BIT $2002; BVS s0a; s0b: BIT $2002; BVC s0b")
+    a("LDA $12; STA $2005; LDA #0; STA $2005")
+    work(a)
+    a("JMP main")
+    nmi(a); a("irq: RTI")
+    data(a, rnd)
+    prg = bytearray(a.assemble()); prg += bytes(0x8000 - len(prg))
+    prg[0x7FFA:0x8000] = bytes([a.labels['nmi'] & 0xff, a.labels['nmi'] >> 8, a.labels['reset'] & 0xff, a.labels['reset'] >> 8, a.labels['irq'] & 0xff, a.labels['irq'] >> 8])
+    chr_ = bytes(rnd.randrange(256) for _ in range(0x2000))
+    open(path, 'wb').write(header(2, 1, 0) + prg + chr_)
+
+def mmc3(path, seed=2):
+    rnd = random.Random(seed)
+    a = Asm(0xC000)   # fixed last 16KB
+    a.label('reset'); common_init(a)
+    # MMC3: set banks, IRQ latch 60, enable
+    a("LDX #0; bk: STX $8000; LDA banks,X; STA $8001; INX; CPX #8; BNE bk; LDA #0; STA $A000")
+    a("LDA #60; STA $C000; STA $C001; STA $E001")
+    a("main:"); work(a); a("JMP main")
+    nmi(a, "LDA #60; STA $C000; STA $C001; STA $E001; LDA #$00; STA $8000; LDA $10; AND #$0E; STA $8001")
+    a("irq: PHA; STA $E000; STA $E001; LDA #$82; STA $8000; INC $16; LDA $16; AND #$0F; STA $8001; LDA #40; STA $C000; STA $C001; LDA $16; STA $2005; STA $2005; PLA; RTI")
+    data(a, rnd)
+    a.label('banks'); a.db(0, 2, 4, 5, 6, 7, 0, 1)
+    fixed = bytearray(a.assemble()); fixed += bytes(0x4000 - len(fixed))
+    fixed[0x3FFA:0x4000] = bytes([a.labels['nmi'] & 0xff, a.labels['nmi'] >> 8, a.labels['reset'] & 0xff, a.labels['reset'] >> 8, a.labels['irq'] & 0xff, a.labels['irq'] >> 8])
+    prg = bytes(rnd.randrange(256) for _ in range(0x4000)) + bytes(fixed)   # 32KB
+    chr_ = bytes(rnd.randrange(256) for _ in range(0x4000))  # 16KB
+    open(path, 'wb').write(header(2, 2, 4, 0) + prg + chr_)
+
+
+def chrram(path, seed=3):
+    rnd = random.Random(seed)
+    a = Asm(0x8000)
+    a.label('reset')
+    a("SEI; CLD; LDX #$FF; TXS")
+    a("vw1: BIT $2002; BPL vw1; vw2: BIT $2002; BPL vw2")
+    # fill the 8KB of CHR RAM from PRG $C000-$DFFF
+    a("LDA #$00; STA $2006; STA $2006; STA $00; LDA #$C0; STA $01; LDX #32; LDY #0")
+    a("cf: LDA ($00),Y; STA $2007; INY; BNE cf; INC $01; DEX; BNE cf")
+    a("LDA #$3F; STA $2006; LDA #$00; STA $2006; LDX #0")
+    a("pal: LDA paldata,X; STA $2007; INX; CPX #32; BNE pal")
+    a("LDA #$20; STA $2006; LDA #$00; STA $2006; LDY #8; LDX #0; LDA #7; STA $00")
+    a("nt: LDA $00; ASL A; BCC nt1; EOR #$1D; nt1: STA $00; STA $2007; INX; BNE nt; DEY; BNE nt")
+    a("LDX #0; oam: LDA oamdata,X; STA $0200,X; INX; BNE oam")
+    a("LDA #0; STA $10; STA $11; STA $12; STA $13")
+    a("LDA #$88; STA $2000; LDA #$1E; STA $2001; CLI")
+    a("main:")
+    a("s0a: BIT $2002; BVS s0a; s0b: BIT $2002; BVC s0b")
+    # rewrite some pattern bytes mid-frame, then restore the scroll
+    a("LDA $10; AND #$1F; STA $2006; LDA $12; STA $2006; LDX #24; w: LDA $12; ADC $13; STA $13; STA $2007; DEX; BNE w")
+    a("LDA #$00; STA $2006; STA $2006; LDA $12; STA $2005; LDA #0; STA $2005")
+    a("LDA $12; CLC; ADC #$37; STA $12; SBC $13; ROR A; STA $13")
+    a("JMP main")
+    nmi(a, "LDA $10; AND #$0F; ORA #$10; STA $2006; LDA $13; STA $2006; LDX #16; nw: TXA; EOR $10; STA $2007; DEX; BNE nw")
+    a("irq: RTI")
+    data(a, rnd)
+    prg = bytearray(a.assemble()); prg += bytes(0x4000 - len(prg))
+    prg += bytes(rnd.randrange(256) for _ in range(0x4000))
+    prg[0x7FFA:0x8000] = bytes([a.labels['nmi'] & 0xff, a.labels['nmi'] >> 8, a.labels['reset'] & 0xff, a.labels['reset'] >> 8, a.labels['irq'] & 0xff, a.labels['irq'] >> 8])
+    open(path, 'wb').write(header(2, 0, 0) + bytes(prg))
+
+if __name__ == '__main__':
+    here = os.path.dirname(os.path.abspath(__file__))
+    nrom(os.path.join(here, 'nrom.nes'))
+    mmc3(os.path.join(here, 'mmc3.nes'))
+    chrram(os.path.join(here, 'chrram.nes'))